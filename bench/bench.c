@@ -0,0 +1,392 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "gol.h"
+#include "functions.h"				//The OpenMP kernels of mpi_omp (the makefile puts mpi_omp before mpi in the include path)
+#include "batch.h"
+#include "ltl.h"
+#include "generations.h"
+#include "unbounded.h"
+
+
+#define MAX_SIZES     32
+#define MAX_DENSITIES 16
+#define MIN_REP_TIME  0.02			//Every repetition runs enough generations to take at least this long (seconds)
+
+
+
+/*Everything the kernels keep between generations (every kernel uses only the fields it needs)*/
+typedef struct state {
+	int      n, threads, radius, bits;
+	char     **old_gen, **new_gen, rule[2][9], *ltlrule, gentable[GEN_MAX_STATES][9], *scratch;
+	int      *colsum, *around;
+	unsigned char **packed, **packed_new, *lut;
+	gol_board *board;
+	universe *u;
+	uint64_t *batch, *batch_new;
+} state;
+
+/*A kernel to measure, bytes is the traffic a cell needs at least (read the old and write the new value), to estimate the bandwidth*/
+typedef struct kernel {
+	const char *name;
+	double     bytes;
+	void       (*setup)(state *s, double density);
+	double     (*step)(state *s);				//One generation, returns the cells that were computed
+	void       (*cleanup)(state *s);
+} kernel;
+
+
+
+/*Seconds of a monotonic clock*/
+static double now(void)
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+
+/*Random cells with the given density in a n x n array (with offset cells of ghost frame around it)*/
+static void randomCells(char **cells, int n, int offset, double density)
+{
+	int i, j;
+	for (i = 0; i < n; i++)
+		for (j = 0; j < n; j++)
+			cells[i+offset][j+offset] = (rand() < density * RAND_MAX);
+}
+
+
+
+/*libgol board (the serial kernel, with the ghost frame filled in every generation)*/
+static void setupBoard(state *s, double density)
+{
+	int i, j;
+	s->board = gol_create(s->n, s->n, "B3/S23");
+	for (i = 0; i < s->n; i++)
+		for (j = 0; j < s->n; j++)
+			gol_cells(s->board)[i*gol_stride(s->board) + j] = (rand() < density * RAND_MAX);
+}
+
+static double stepBoard(state *s)
+{
+	gol_step(s->board, 1);
+	return (double)s->n * s->n;
+}
+
+static void cleanupBoard(state *s)
+{
+	gol_destroy(s->board);
+}
+
+
+
+/*evolve_inner() and evolve_sides() of mpi_omp, on a padded block without the halo exchange*/
+static void setupBlock(state *s, double density)
+{
+	gol_parse_rule("B3/S23", s->rule);
+	s->old_gen = allocateArray(s->n + 2, 0);
+	s->new_gen = allocateArray(s->n + 2, 0);
+	randomCells(s->old_gen, s->n + 2, 0, density);		//The ghost frame too, as if it were received
+}
+
+static double stepInner(state *s)
+{
+	int  allzeros = 0, change = 0;
+	char **swap;
+	evolve_inner(s->old_gen, s->new_gen, s->n, s->rule, s->threads, &allzeros, &change, NULL);
+	swap       = s->old_gen;
+	s->old_gen = s->new_gen;
+	s->new_gen = swap;
+	return (double)(s->n-2) * (s->n-2);
+}
+
+static double stepSides(state *s)
+{
+	int allzeros = 0, change = 0;
+	evolve_sides(s->old_gen, s->new_gen, s->n, s->rule, s->threads, &allzeros, &change, NULL);
+	return 4.0 * s->n - 4;
+}
+
+static void cleanupBlock(state *s)
+{
+	deleteArray(&(s->old_gen));
+	deleteArray(&(s->new_gen));
+}
+
+
+
+/*evolve_inner_lut() of mpi_omp (2x2 cells with one lookup), on the same block as evolve_inner()*/
+static void setupLookup(state *s, double density)
+{
+	setupBlock(s, density);
+	s->lut = buildLookup(s->rule);
+}
+
+static double stepLookup(state *s)
+{
+	int  allzeros = 0, change = 0;
+	char **swap;
+	evolve_inner_lut(s->old_gen, s->new_gen, s->n, s->rule, s->lut, s->threads, &allzeros, &change);
+	swap       = s->old_gen;
+	s->old_gen = s->new_gen;
+	s->new_gen = swap;
+	return (double)(s->n-2) * (s->n-2);
+}
+
+static void cleanupLookup(state *s)
+{
+	cleanupBlock(s);
+	free(s->lut);
+}
+
+
+
+/*Larger than Life (evolve_ltl() of mpi, range 5)*/
+static void setupLtL(state *s, double density)
+{
+	s->ltlrule = parseLtLRule("R5,C0,M1,S34..58,B34..45,NM", &(s->radius));
+	s->old_gen = allocateArray(s->n + 2*s->radius, 0);
+	s->new_gen = allocateArray(s->n + 2*s->radius, 0);
+	s->colsum  = malloc((s->n + 2*s->radius) * sizeof(int));
+	randomCells(s->old_gen, s->n, s->radius, density);
+}
+
+static double stepLtL(state *s)
+{
+	int  allzeros = 0, change = 0, r = s->radius;
+	char **swap;
+	fillGhosts(s->old_gen, s->n, r);
+	evolve_ltl(s->old_gen, s->new_gen, r, r, s->n+r, r, s->n+r, s->ltlrule, s->colsum, &allzeros, &change, NULL);
+	swap       = s->old_gen;
+	s->old_gen = s->new_gen;
+	s->new_gen = swap;
+	return (double)s->n * s->n;
+}
+
+static void cleanupLtL(state *s)
+{
+	deleteArray(&(s->old_gen));
+	deleteArray(&(s->new_gen));
+	free(s->colsum);
+	free(s->ltlrule);
+}
+
+
+
+/*Generations with packed cells (evolve_generations() of mpi, Brian's Brain with 2 bits per cell)*/
+static void setupGenerations(state *s, double density)
+{
+	int  states;
+	char **cells = allocateArray(s->n, 0);
+
+	parseGenRule("B2/S/C3", s->gentable, &states);
+	s->bits       = packedBits(states);
+	s->packed     = allocatePacked(s->n+2, packedBytes(s->n+2, s->bits));
+	s->packed_new = allocatePacked(s->n+2, packedBytes(s->n+2, s->bits));
+	s->scratch    = malloc(5*(s->n+2) * sizeof(char));
+	randomCells(cells, s->n, 0, density);
+	packBlock(cells, s->packed, s->n, s->bits);
+	deleteArray(&cells);
+}
+
+static double stepGenerations(state *s)
+{
+	int  allzeros = 0, change = 0;
+	unsigned char **swap;
+	fillPackedGhosts(s->packed, s->n, s->bits);
+	evolve_generations(s->packed, s->packed_new, 1, s->n+1, s->n, s->bits, s->gentable, s->scratch, &allzeros, &change);
+	swap          = s->packed;
+	s->packed     = s->packed_new;
+	s->packed_new = swap;
+	return (double)s->n * s->n;
+}
+
+static void cleanupGenerations(state *s)
+{
+	deletePacked(&(s->packed));
+	deletePacked(&(s->packed_new));
+	free(s->scratch);
+}
+
+
+
+/*Unbounded plane of 64 x 64 bitboard chunks (the cells computed are all the cells of the allocated chunks)*/
+static void setupUnbounded(state *s, double density)
+{
+	int i, j;
+	gol_parse_rule("B3/S23", s->rule);
+	s->u = createUniverse();
+	for (i = 0; i < s->n; i++)
+		for (j = 0; j < s->n; j++)
+			if (rand() < density * RAND_MAX) setCellUnbounded(s->u, i, j);
+}
+
+static double stepUnbounded(state *s)
+{
+	int    allzeros = 0, change = 0;
+	double cells = (double)s->u->count * CHUNK_SIZE * CHUNK_SIZE;
+	evolveUnbounded(s->u, s->rule, &allzeros, &change);
+	return cells;
+}
+
+static void cleanupUnbounded(state *s)
+{
+	deleteUniverse(&(s->u));
+}
+
+
+
+/*Batch of 64 boards bit-sliced in words (step_group() of mpi_omp, the sweep of one generation of evolve_group() without its buffers)*/
+static void setupBatch(state *s, double density)
+{
+	int i, k;
+	gol_parse_rule("B3/S23", s->rule);
+	s->batch     = allocateGroups(1, s->n);
+	s->batch_new = allocateGroups(1, s->n);
+	s->around    = groupNeighbours(s->n);
+	for (i = 0; i < s->n*s->n; i++)
+		for (k = 0; k < BATCH_LANES; k++)
+			if (rand() < density * RAND_MAX) s->batch[i] |= (uint64_t)1 << k;
+}
+
+static double stepBatch(state *s)
+{
+	uint64_t anyalive, changed, period2, *swap;
+	step_group(s->batch, s->batch_new, NULL, s->n, s->around, s->rule, ~(uint64_t)0, &anyalive, &changed, &period2);
+	swap         = s->batch;
+	s->batch     = s->batch_new;
+	s->batch_new = swap;
+	return (double)BATCH_LANES * s->n * s->n;
+}
+
+static void cleanupBatch(state *s)
+{
+	deleteGroups(s->batch);
+	deleteGroups(s->batch_new);
+	free(s->around);
+}
+
+
+
+static kernel kernels[] = {
+	{"gol_step",           2.0,        setupBoard,       stepBoard,       cleanupBoard},
+	{"evolve_inner",       2.0,        setupBlock,       stepInner,       cleanupBlock},
+	{"evolve_sides",       2.0,        setupBlock,       stepSides,       cleanupBlock},
+	{"evolve_inner_lut",   2.0,        setupLookup,      stepLookup,      cleanupLookup},
+	{"evolve_ltl",         2.0,        setupLtL,         stepLtL,         cleanupLtL},
+	{"evolve_generations", 2.0*2/8,    setupGenerations, stepGenerations, cleanupGenerations},
+	{"unbounded",          2.0/8,      setupUnbounded,   stepUnbounded,   cleanupUnbounded},
+	{"batch",              2.0*8/64,   setupBatch,       stepBatch,       cleanupBatch},
+};
+
+
+
+/*Read a comma separated list of numbers (returns how many)*/
+static int readList(const char *text, double *list, int max)
+{
+	int  count = 0;
+	char *copy = strdup(text), *token;
+
+	for (token = strtok(copy, ","); (token != NULL) && (count < max); token = strtok(NULL, ","))
+		list[count++] = atof(token);
+	free(copy);
+	return count;
+}
+
+
+
+static int compareDoubles(const void *a, const void *b)
+{
+	double da = *(const double *)a, db = *(const double *)b;
+	return (da > db) - (da < db);
+}
+
+
+
+/*Kernel microbenchmark - In command line (example): ./gol-bench -s 64,1024 -d 0.3 -k evolve_inner -t 2 -o bench.json*/
+int main(int argc, char *argv[])
+{
+	int    i, k, z, d, q, r, steps, sizecount, densitycount, threads = 1, reps = 5, warmup = 1, first = 1;
+	double sizes[MAX_SIZES] = {32, 64, 128, 256, 512, 1024, 2048}, densities[MAX_DENSITIES] = {0.1, 0.3, 0.5};
+	double t, cells, times[64], median, best;
+	char   *only = NULL;
+	FILE   *json = NULL;
+	state  s;
+
+	sizecount    = 7;
+	densitycount = 3;
+
+	/*Read the arguments*/
+	for (i = 1; i < argc; i++){
+		if (!strcmp(argv[i], "-s")) sizecount = readList(argv[++i], sizes, MAX_SIZES);
+		else if (!strcmp(argv[i], "-d")) densitycount = readList(argv[++i], densities, MAX_DENSITIES);
+		else if (!strcmp(argv[i], "-k")) only = argv[++i];
+		else if (!strcmp(argv[i], "-t")) threads = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-r")) reps = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-w")) warmup = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-o")) json = fopen(argv[++i], "w");
+	}
+	if ((reps < 1) || (reps > 64) || (threads < 1)){
+		fprintf(stderr, "The repetitions must be 1 to 64 and the threads at least 1\n");
+		return 1;
+	}
+
+	if (json != NULL) fprintf(json, "[\n");
+	printf("%-20s %6s %8s %8s %10s %12s %10s %10s\n", "kernel", "size", "density", "threads", "steps", "cells/s", "ns/cell", "GB/s");
+
+	for (k = 0; k < (int)(sizeof(kernels) / sizeof(kernel)); k++){
+		if ((only != NULL) && strcmp(only, kernels[k].name)) continue;
+		for (z = 0; z < sizecount; z++){
+			for (d = 0; d < densitycount; d++){
+				memset(&s, 0, sizeof(state));
+				s.n       = (int)sizes[z];
+				s.threads = threads;
+				srand(1);
+				kernels[k].setup(&s, densities[d]);
+
+				/*Double the generations until they take MIN_REP_TIME (this warms up the caches as well), warm up more and repeat*/
+				for (steps = 1; ; steps *= 2){
+					t = now();
+					for (q = 0; q < steps; q++)
+						kernels[k].step(&s);
+					if (now() - t >= MIN_REP_TIME) break;
+				}
+				for (r = 0; r < warmup; r++)
+					for (q = 0; q < steps; q++)
+						kernels[k].step(&s);
+				cells = 0;
+				for (r = 0; r < reps; r++){
+					t = now();
+					for (q = 0; q < steps; q++)
+						cells += kernels[k].step(&s);
+					times[r] = (now() - t) / steps;
+				}
+				cells /= (double)reps * steps;			//Cells of a generation (they change only on the unbounded plane)
+				kernels[k].cleanup(&s);
+
+				qsort(times, reps, sizeof(double), compareDoubles);
+				median = (reps % 2) ? times[reps/2] : (times[reps/2-1] + times[reps/2]) / 2;
+				best   = times[0];
+				printf("%-20s %6d %8.2f %8d %10d %12.4g %10.3f %10.3f\n", kernels[k].name, s.n, densities[d], threads, steps,
+					cells / median, median * 1e9 / cells, cells * kernels[k].bytes / median * 1e-9);
+
+				if (json != NULL){
+					fprintf(json, "%s  {\"kernel\": \"%s\", \"size\": %d, \"density\": %g, \"threads\": %d, \"steps\": %d, \"repetitions\": %d, "
+						"\"cells_per_step\": %.0f, \"seconds_per_step_median\": %.9g, \"seconds_per_step_min\": %.9g, "
+						"\"cells_per_second\": %.6g, \"ns_per_cell\": %.6g, \"bytes_per_step\": %.6g, \"bytes_per_second\": %.6g}",
+						first ? "" : ",\n", kernels[k].name, s.n, densities[d], threads, steps, reps,
+						cells, median, best, cells / median, median * 1e9 / cells, cells * kernels[k].bytes, cells * kernels[k].bytes / median);
+					first = 0;
+				}
+			}
+		}
+	}
+
+	if (json != NULL){
+		fprintf(json, "\n]\n");
+		fclose(json);
+	}
+	return 0;
+}
@@ -2,10 +2,33 @@
 #include <stdlib.h>
 #include <time.h>
 #include <math.h>
+#include <string.h>
+#include <ctype.h>
 
 #define BUFSIZE 64
 #define BLOCK_SIZE 25
 
+// Transition table of the rule, rule[cell][neighbors] gives the next value of the cell
+// Lives in constant memory, so every rule runs through the very same kernels
+__constant__ char d_rule[2][9];
+
+// Build the transition table of a Life-like rule given as a B/S rulestring (e.g. B3/S23, B36/S23, B2/S)
+int parseRule(const char *rulestring, char rule[2][9])
+{
+    int state = -1;
+    const char *p;
+
+    memset(rule, 0, 2*9*sizeof(char));
+    for (p = rulestring; *p != '\0'; p++){
+        if (*p == 'B' || *p == 'b') state = 0;          // Birth digits follow
+        else if (*p == 'S' || *p == 's') state = 1;     // Survival digits follow
+        else if (*p == '/') state = -1;
+        else if (state != -1 && isdigit((unsigned char)*p) && *p != '9') rule[state][*p - '0'] = 1;
+        else return -1;
+    }
+    return 0;
+}
+
 // Perdiodicty Preservation retains our periodicity
 // Runs on CPU 
 void periodicityPreservationCPU(int N, char *cells)
@@ -76,7 +99,7 @@ __global__ void evovle_kernel(int N, char *oldGen, char *newGen, int *allzeros,
                     + oldGen[id-(N+1)] + oldGen[id+(N+1)];
  
         char cell  = oldGen[id];
-        newGen[id] = neighbors == 3 || (neighbors == 2 && cell); // Fill in the cells
+        newGen[id] = d_rule[(int)cell][neighbors];    // Fill in the cells from the transition table
 
         // Terminating Checkings
         if (newGen[id] != 0) (*allzeros)++;             // Check if all cells are dead
@@ -118,7 +141,7 @@ __global__ void evovle_kernel_shared(int N, char *oldGen, char *newGen, int *all
                     + oldGen_shared[i-1][j+1] + oldGen_shared[i+1][j-1];
  
             char cell  = oldGen_shared[i][j];
-			newGen[id] = neighbors == 3 || (neighbors == 2 && cell); // Fill in  the cells
+			newGen[id] = d_rule[(int)cell][neighbors];    // Fill in the cells from the transition table
 
             // Terminating Checkings
             if (newGen[id] != 0) (*allzeros)++;        // Check if all cells are dead
@@ -139,6 +162,8 @@ int main(int argc, char* argv[])
     int output = 0;     // Print the array in every generation, at the end or not at all
     int periodicity = 1;   // Choose if we want the calculate the periodicity of side cells in cpu or gpu
     int doom = 0 ; 		// With terminal checking or Not 
+    char rule[2][9];    // Transition table of the rule
+    char *rulestring = (char*)"B3/S23";    // Conway's rule by default
 
     /*Read the arguments*/
     for (i = 0; i < argc; i++){
@@ -150,6 +175,13 @@ int main(int argc, char* argv[])
         else if (!strcmp(argv[i], "-o1")) output = 1;
         else if (!strcmp(argv[i], "-o2")) output = 2;
         else if (!strcmp(argv[i], "-d")) doom = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r")) rulestring = argv[++i];
+    }
+
+    // Build the transition table of the rule, or else exit
+    if (parseRule(rulestring, rule) != 0){
+        fprintf(stderr, "Invalid rule %s (B/S notation is expected, e.g. B36/S23)\n", rulestring);
+        return 1;
     }
 
     // Definitions of one dimension arrays on host and device
@@ -212,6 +244,9 @@ int main(int argc, char* argv[])
 
     // Let's fill our device cells 
     cudaMemcpy(d_old, h_cells, bytes, cudaMemcpyHostToDevice);
+
+    // Copy the transition table of the rule in constant memory of the device
+    cudaMemcpyToSymbol(d_rule, rule, sizeof(rule));
  
     // Set the prefferes cache configuration for the device function if we want to use shared memory
     if (shared == 1) cudaFuncSetCacheConfig(evovle_kernel_shared, cudaFuncCachePreferShared);
@@ -0,0 +1,290 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include "gol.h"
+
+
+/*A board keeps its cells with a ghost frame one cell wide (filled with the opposite sides before every generation), so that the*/
+/*kernel needs no modulos, and two such arrays for the current and the next generation*/
+struct gol_board {
+	int  rows, cols, stride;
+	long generation;
+	char rule[2][9];
+	char *current, *next;			//(rows+2) x (cols+2) cells each
+};
+
+
+
+/*Build the transition table of a Life-like rule given as a B/S rulestring (e.g. B3/S23, B36/S23, B2/S)*/
+int gol_parse_rule(const char *rulestring, char rule[2][9])
+{
+	int  i, state;
+	const char *p;
+
+	memset(rule, 0, 2*9*sizeof(char));			//Every cell dies or stays dead, unless the rulestring says otherwise
+	state = -1;
+	for (p = rulestring; *p != '\0'; p++){
+		if ((*p == 'B') || (*p == 'b')) state = 0;				//Birth digits follow (dead cell becomes alive)
+		else if ((*p == 'S') || (*p == 's')) state = 1;			//Survival digits follow (live cell stays alive)
+		else if (*p == '/') state = -1;
+		else if ((state != -1) && isdigit((unsigned char)*p) && (*p != '9')){
+			i = *p - '0';
+			rule[state][i] = 1;					//rule[cell][neighbours] is the value of the cell in the next generation
+		}
+		else return -1;							//Not a B/S rulestring
+	}
+	return 0;
+}
+
+
+
+/*The cells in rows row0..row1-1 and columns col0..col1-1 of an array (rows stride cells apart) evolve, all their neighbours must*/
+/*be in the array (inner cells of a block, or a board with a ghost frame), allzeros and change are set to 1 as in the MPI programs*/
+void gol_evolve(const char *old_gen, char *new_gen, int stride, int row0, int row1, int col0, int col1, char rule[2][9], int *allzeros, int *change)
+{
+	int  i, j, neighbours;
+	const char *up, *mid, *down;
+	char *out, alive = 0, changed = 0;
+
+	for (i = row0; i < row1; i++){
+		up   = old_gen + (i-1)*stride;
+		mid  = old_gen + i*stride;
+		down = old_gen + (i+1)*stride;
+		out  = new_gen + i*stride;
+		for (j = col0; j < col1; j++){
+			neighbours = up[j-1] + up[j] + up[j+1] + mid[j-1] + mid[j+1] + down[j-1] + down[j] + down[j+1];
+			out[j]   = rule[(int)mid[j]][neighbours];
+			alive   |= out[j];
+			changed |= out[j] ^ mid[j];
+		}
+	}
+	if (alive) *allzeros = 1;
+	if (changed) *change = 1;
+}
+
+
+
+/*Empty statistics, with a bounding box that any live cell replaces*/
+void gol_stats_clear(gol_stats *stats)
+{
+	stats->population = stats->births = stats->deaths = 0;
+	stats->top    = stats->left  = INT_MAX;
+	stats->bottom = stats->right = -1;
+}
+
+
+
+/*The same as gol_evolve(), that also counts the live cells, the births and the deaths and grows the bounding box in the same sweep*/
+/*(the counts are kept per row, and only the columns out of the box so far are searched for its left and right side)*/
+void gol_evolve_stats(const char *old_gen, char *new_gen, int stride, int row0, int row1, int col0, int col1, char rule[2][9], int *allzeros, int *change, gol_stats *stats)
+{
+	int  i, j, neighbours, population, births, deaths;
+	const char *up, *mid, *down;
+	char *out, alive = 0, changed = 0;
+
+	if (stats == NULL){
+		gol_evolve(old_gen, new_gen, stride, row0, row1, col0, col1, rule, allzeros, change);
+		return;
+	}
+	for (i = row0; i < row1; i++){
+		up   = old_gen + (i-1)*stride;
+		mid  = old_gen + i*stride;
+		down = old_gen + (i+1)*stride;
+		out  = new_gen + i*stride;
+		population = births = deaths = 0;
+		for (j = col0; j < col1; j++){
+			neighbours  = up[j-1] + up[j] + up[j+1] + mid[j-1] + mid[j+1] + down[j-1] + down[j] + down[j+1];
+			out[j]      = rule[(int)mid[j]][neighbours];
+			population += out[j];
+			births     += out[j] & ~mid[j];
+			deaths     += mid[j] & ~out[j];
+		}
+		stats->population += population;
+		stats->births     += births;
+		stats->deaths     += deaths;
+		alive   |= (population > 0);
+		changed |= (births + deaths > 0);
+		if (population == 0) continue;
+
+		if (i < stats->top) stats->top = i;
+		if (i > stats->bottom) stats->bottom = i;
+		for (j = col0; (j < col1) && (j < stats->left); j++)
+			if (out[j]){
+				stats->left = j;
+				break;
+			}
+		for (j = col1-1; (j >= col0) && (j > stats->right); j--)
+			if (out[j]){
+				stats->right = j;
+				break;
+			}
+	}
+	if (alive) *allzeros = 1;
+	if (changed) *change = 1;
+}
+
+
+
+/*Create an empty board (returns NULL if the rule is not a B/S rulestring)*/
+gol_board *gol_create(int rows, int cols, const char *rulestring)
+{
+	gol_board *board;
+
+	if ((rows < 1) || (cols < 1)) return NULL;
+	board = malloc(sizeof(gol_board));
+	if (gol_parse_rule(rulestring, board->rule) != 0){
+		free(board);
+		return NULL;
+	}
+	board->rows       = rows;
+	board->cols       = cols;
+	board->stride     = cols + 2;
+	board->generation = 0;
+	board->current    = calloc((size_t)(rows+2)*(cols+2), sizeof(char));
+	board->next       = calloc((size_t)(rows+2)*(cols+2), sizeof(char));
+	return board;
+}
+
+
+
+/*Create a board with the cells of a memory buffer (rows stride chars apart, any non zero char is a live cell)*/
+gol_board *gol_create_from(const char *cells, int rows, int cols, int stride, const char *rulestring)
+{
+	int  i, j;
+	char *row;
+	gol_board *board = gol_create(rows, cols, rulestring);
+
+	if (board == NULL) return NULL;
+	for (i = 0; i < rows; i++){
+		row = gol_cells(board) + i*board->stride;
+		for (j = 0; j < cols; j++)
+			row[j] = (cells[(size_t)i*stride + j] != 0);
+	}
+	return board;
+}
+
+
+
+/*Delete a board*/
+void gol_destroy(gol_board *board)
+{
+	if (board == NULL) return;
+	free(board->current);
+	free(board->next);
+	free(board);
+}
+
+
+
+/*Change the rule of a board (returns -1 and keeps the old one if the rule is not a B/S rulestring)*/
+int gol_set_rule(gol_board *board, const char *rulestring)
+{
+	char rule[2][9];
+
+	if (gol_parse_rule(rulestring, rule) != 0) return -1;
+	memcpy(board->rule, rule, sizeof(rule));
+	return 0;
+}
+
+
+
+/*Copy the opposite sides of the board in its ghost frame*/
+static void fillFrame(gol_board *board)
+{
+	int  i, R = board->rows, C = board->cols, S = board->stride;
+	char *cells = board->current;
+
+	for (i = 1; i <= R; i++){
+		cells[i*S]       = cells[i*S + C];
+		cells[i*S + C+1] = cells[i*S + 1];
+	}
+	memcpy(cells, cells + R*S, S);					//Up ghost row is the last row (with the corners already in it)
+	memcpy(cells + (R+1)*S, cells + S, S);			//Down ghost row is the first one
+}
+
+
+
+/*Move the board forward a number of generations, returns GOL_ALIVE and GOL_CHANGED for the last one (0 if there were none)*/
+int gol_step(gol_board *board, int generations)
+{
+	int  q, allzeros = 0, change = 0;
+	char *swap;
+
+	for (q = 0; q < generations; q++){
+		allzeros = 0;
+		change   = 0;
+		fillFrame(board);
+		gol_evolve(board->current, board->next, board->stride, 1, board->rows+1, 1, board->cols+1, board->rule, &allzeros, &change);
+		swap           = board->current;
+		board->current = board->next;
+		board->next    = swap;
+		board->generation++;
+	}
+	return (allzeros ? GOL_ALIVE : 0) | (change ? GOL_CHANGED : 0);
+}
+
+
+
+int gol_rows(const gol_board *board)
+{
+	return board->rows;
+}
+
+
+
+int gol_cols(const gol_board *board)
+{
+	return board->cols;
+}
+
+
+
+/*Generations computed since the board was created*/
+long gol_generation(const gol_board *board)
+{
+	return board->generation;
+}
+
+
+
+/*Live cells of the board*/
+long gol_population(const gol_board *board)
+{
+	return gol_region_population(board, 0, 0, board->rows, board->cols);
+}
+
+
+
+/*Live cells of a region of the board (it may wrap around the sides)*/
+long gol_region_population(const gol_board *board, int row0, int col0, int rows, int cols)
+{
+	int  i, j, r, c;
+	long alive = 0;
+
+	for (i = 0; i < rows; i++){
+		r = ((row0 + i) % board->rows + board->rows) % board->rows;
+		for (j = 0; j < cols; j++){
+			c = ((col0 + j) % board->cols + board->cols) % board->cols;
+			alive += board->current[(r+1)*board->stride + c+1];
+		}
+	}
+	return alive;
+}
+
+
+
+/*The cells of the current generation without a copy, cell (i, j) is gol_cells(board)[i*gol_stride(board) + j]*/
+/*They may be changed between generations, but the pointer is valid only until the next gol_step()*/
+char *gol_cells(gol_board *board)
+{
+	return board->current + board->stride + 1;
+}
+
+
+
+int gol_stride(const gol_board *board)
+{
+	return board->stride;
+}
@@ -0,0 +1,47 @@
+#ifndef __gol__
+#define __gol__
+
+
+/*libgol - the Game of Life core as a library, to step boards from another program without a new process or text files*/
+/*Cells are chars (0 or 1), rules are Life-like B/S rulestrings and boards wrap around (torus)*/
+
+#define GOL_VERSION 1				//Raised only if the functions below change in a way that breaks programs using them
+
+/*Flags returned by gol_step() for the last generation it computed*/
+#define GOL_ALIVE   1				//At least one live cell (like allzeros in the MPI programs)
+#define GOL_CHANGED 2				//Different from the previous generation (like change)
+
+
+typedef struct gol_board gol_board;
+
+/*Statistics of the cells gol_evolve_stats() computed, added to the ones already in it (gol_stats_clear() empties them)*/
+typedef struct {
+	long population, births, deaths;
+	int  top, left, bottom, right;			//Bounding box of the live cells in the rows and columns of the array, top > bottom if none
+} gol_stats;
+
+
+/*Rules and the kernel*/
+int  gol_parse_rule(const char *rulestring, char rule[2][9]);
+void gol_evolve(const char *old_gen, char *new_gen, int stride, int row0, int row1, int col0, int col1, char rule[2][9], int *allzeros, int *change);
+void gol_evolve_stats(const char *old_gen, char *new_gen, int stride, int row0, int row1, int col0, int col1, char rule[2][9], int *allzeros, int *change, gol_stats *stats);
+void gol_stats_clear(gol_stats *stats);
+
+/*Boards*/
+gol_board *gol_create(int rows, int cols, const char *rulestring);
+gol_board *gol_create_from(const char *cells, int rows, int cols, int stride, const char *rulestring);
+void gol_destroy(gol_board *board);
+int  gol_set_rule(gol_board *board, const char *rulestring);
+int  gol_step(gol_board *board, int generations);
+
+/*Queries and access to the cells*/
+int  gol_rows(const gol_board *board);
+int  gol_cols(const gol_board *board);
+long gol_generation(const gol_board *board);
+long gol_population(const gol_board *board);
+long gol_region_population(const gol_board *board, int row0, int col0, int rows, int cols);
+char *gol_cells(gol_board *board);
+int  gol_stride(const gol_board *board);
+
+
+#endif
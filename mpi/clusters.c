@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <omp.h>
+#include "mpi.h"
+#include "clusters.h"
+
+
+enum {CLUSTER_LABEL, CLUSTER_CELLS, CLUSTER_TOP, CLUSTER_LEFT, CLUSTER_BOTTOM, CLUSTER_RIGHT, CLUSTER_ROWS, CLUSTER_COLUMNS, CLUSTER_WRAPS};
+
+#define LINE   160				//Longest line of a cluster in the file
+#define BORDER 3				//Label, row shift and column shift of every cell of the borders
+
+
+
+/*The root of a cell (its set is linked to the smallest cell, so every cell points to a smaller one), halving the path on the way*/
+static long findRoot(long *parent, long x)
+{
+	while (parent[x] != x){
+		parent[x] = parent[parent[x]];
+		x = parent[x];
+	}
+	return x;
+}
+
+
+
+static void unite(long *parent, long a, long b)
+{
+	a = findRoot(parent, a);
+	b = findRoot(parent, b);
+	if (a < b) parent[b] = a;
+	else if (b < a) parent[a] = b;
+}
+
+
+
+/*Label the live cells of rows row0 ... row1-1 of the block (8-connectivity, only with the cells of these rows)*/
+static void labelRows(char **cells, int n, int frame, long *parent, int row0, int row1)
+{
+	int  i, j, k;
+	long x;
+
+	for (i = row0; i < row1; i++){
+		for (j = 0; j < n; j++){
+			x = (long)i*n + j;
+			if (cells[frame+i][frame+j] != 1){
+				parent[x] = -1;
+				continue;
+			}
+			parent[x] = x;
+			if ((j > 0) && (cells[frame+i][frame+j-1] == 1)) unite(parent, x, x-1);
+			if (i == row0) continue;
+			for (k = -1; k <= 1; k++)
+				if ((j+k >= 0) && (j+k < n) && (cells[frame+i-1][frame+j+k] == 1)) unite(parent, x, x-n+k);
+		}
+	}
+}
+
+
+
+/*Cluster of a cell of the block (-1 if it is dead), once parent holds -(cluster+2)*/
+static long clusterOf(const long *parent, int n, int i, int j)
+{
+	long x = parent[(long)i*n + j];
+
+	return (x == -1) ? -1 : -x-2;
+}
+
+
+
+/*The label and the shift of the cluster of a cell of the block, in its place of a border (label -1 if the cell is dead)*/
+static void borderCell(const long *parent, const long long *label, const long long *shift, int n, int i, int j, long long *out)
+{
+	long c = clusterOf(parent, n, i, j);
+
+	out[0] = (c < 0) ? -1 : label[c];
+	out[1] = (c < 0) ? 0 : shift[2*c];
+	out[2] = (c < 0) ? 0 : shift[2*c+1];
+}
+
+
+
+/*The label and the shift of the cluster of every cell of the borders of the block, towards each of the 8 neighbours (clockwise from*/
+/*upleft)*/
+static void fillBorders(const long *parent, const long long *label, const long long *shift, int n, long long *out[8])
+{
+	int  k;
+	int  corner[8][2] = {{0, 0}, {0, 0}, {0, n-1}, {0, 0}, {n-1, n-1}, {0, 0}, {n-1, 0}, {0, 0}};
+
+	for (k = 0; k < 8; k += 2)
+		borderCell(parent, label, shift, n, corner[k][0], corner[k][1], out[k]);
+	for (k = 0; k < n; k++){
+		borderCell(parent, label, shift, n, 0, k, out[1] + BORDER*k);			//Up
+		borderCell(parent, label, shift, n, k, n-1, out[3] + BORDER*k);		//Right
+		borderCell(parent, label, shift, n, n-1, k, out[5] + BORDER*k);		//Down
+		borderCell(parent, label, shift, n, k, 0, out[7] + BORDER*k);			//Left
+	}
+}
+
+
+
+/*Label and shift of the cell (i, j) just out of the block, from the borders of the neighbours (in[d] came from the neighbour opposite*/
+/*to d)*/
+static long long *ghostCell(long long *in[8], int n, int i, int j)
+{
+	if (i < 0) return (j < 0) ? in[4] : (j >= n) ? in[6] : in[5] + BORDER*j;
+	if (i >= n) return (j < 0) ? in[2] : (j >= n) ? in[0] : in[1] + BORDER*j;
+	return (j < 0) ? in[3] + BORDER*i : in[7] + BORDER*i;
+}
+
+
+
+static int compareLabels(const void *a, const void *b)
+{
+	long long la = *(const long long *)a, lb = *(const long long *)b;
+
+	return (la > lb) - (la < lb);
+}
+
+
+
+/*Connected clusters of live cells (8-connectivity) on the board, after the last generation (-C in cmd)*/
+/*1. Every process labels its block with union-find, the rows split among threads and the rows between them joined afterwards*/
+/*2. Every cluster of a block starts with a label of its own in the board (rank*n*n + its first cell), the labels on the borders go*/
+/*   to the 8 Cartesian neighbours and every cluster takes the smallest label it touches, until no label changes anywhere. With the*/
+/*   label a piece takes the shift (multiples of the board side) that places it next to the piece it came from, so every cluster is*/
+/*   unwrapped from the torus around the cell of its label. A cluster that wraps around the torus itself meets its own label with*/
+/*   another shift and cannot be unwrapped, it is flagged*/
+/*3. The size, bounding box and the sums of the rows and columns of every piece go to the process of its label, which joins them*/
+/*Every process writes its clusters (cluster,cells,top,left,bottom,right,row,column,wraps with the centroid) in its place in the*/
+/*file, returns the clusters of the board, or -1 if the file cannot be written*/
+long clustersWrite(const char *filename, char **cells, int n, int frame, int threads, int my_rank, int SideProcesses, int neighbours[8], MPI_Comm comm)
+{
+	int  d, i, j, k, m, changed, anychanged, processes = SideProcesses*SideProcesses, length;
+	int  row0 = (my_rank / SideProcesses) * n, col0 = (my_rank % SideProcesses) * n;
+	int  di[8] = {-1, -1, -1, 0, 1, 1, 1, 0}, dj[8] = {-1, 0, 1, 1, 1, 0, -1, -1};
+	int  sizes[8] = {1, n, 1, n, 1, n, 1, n}, *sendcounts, *senddispls, *recvcounts, *recvdispls, *place;
+	long x, c, clusters = 0, mine = 0, first = 0, all;
+	long *parent = malloc((long)n*n * sizeof(long));
+	long long *label, *shift, *records, *sent, *received, *r, *out[8], *in[8], *g, cellsperblock = (long long)n*n, side = (long long)n*SideProcesses;
+	long long across[2];
+	double centre[2];
+	char *text, *wraps, header[] = "cluster,cells,top,left,bottom,right,row,column,wraps\n";
+	MPI_Request request[16];
+	MPI_File fp;
+
+	/*1. The rows of the block in strips, one for each thread, then the first row of every strip with the last one of the strip above*/
+	#	pragma omp parallel num_threads(threads) default(none) shared(cells, n, frame, parent, threads)
+	{
+		int t = omp_get_thread_num();
+
+		labelRows(cells, n, frame, parent, (int)((long)t*n / threads), (int)((long)(t+1)*n / threads));
+	}
+	for (k = 1; k < threads; k++){
+		i = (int)((long)k*n / threads);
+		if ((i == 0) || (i >= n)) continue;
+		for (j = 0; j < n; j++){
+			if (cells[frame+i][frame+j] != 1) continue;
+			for (m = -1; m <= 1; m++)
+				if ((j+m >= 0) && (j+m < n) && (cells[frame+i-1][frame+j+m] == 1)) unite(parent, (long)i*n + j, (long)(i-1)*n + j+m);
+		}
+	}
+
+	/*Number the clusters of the block in the order of their first cell: every cell points to a smaller one, which has its number*/
+	for (x = 0; x < (long)n*n; x++){
+		if (parent[x] == -1) continue;
+		if (parent[x] == x) parent[x] = -(clusters++) - 2;
+		else parent[x] = parent[parent[x]];
+	}
+
+	/*2. The labels of the clusters that touch each other through the borders of the blocks become the smallest one*/
+	label = malloc((clusters + 1) * sizeof(long long));
+	shift = calloc(2*(clusters + 1), sizeof(long long));
+	wraps = malloc((clusters + 1) * sizeof(char));
+	for (x = 0, c = 0; x < (long)n*n; x++)
+		if (-parent[x]-2 == c) label[c++] = my_rank*cellsperblock + x;			//The first cell of cluster c
+	for (d = 0; d < 8; d++){
+		out[d] = malloc(BORDER*sizes[d] * sizeof(long long));
+		in[d]  = malloc(BORDER*sizes[d] * sizeof(long long));
+	}
+	do {
+		fillBorders(parent, label, shift, n, out);
+		for (d = 0; d < 8; d++){
+			MPI_Isend(out[d], BORDER*sizes[d], MPI_LONG_LONG, neighbours[d], d, comm, &request[2*d]);
+			MPI_Irecv(in[d], BORDER*sizes[d], MPI_LONG_LONG, neighbours[(d+4)%8], d, comm, &request[2*d+1]);
+		}
+		MPI_Waitall(16, request, MPI_STATUSES_IGNORE);
+
+		/*Only the cells of the borders, every column of the first and the last row and the first and the last column of the others.*/
+		/*Across the side of the board the neighbour is a whole side away, which its shift must make up for (across)*/
+		changed = 0;
+		memset(wraps, 0, clusters + 1);
+		for (i = 0; i < n; i++){
+			for (j = 0; j < n; j += ((i == 0) || (i == n-1) || (j == n-1)) ? 1 : n-1){
+				c = clusterOf(parent, n, i, j);
+				if (c < 0) continue;
+				for (d = 0; d < 8; d++){
+					if ((i+di[d] >= 0) && (i+di[d] < n) && (j+dj[d] >= 0) && (j+dj[d] < n)) continue;
+					g = ghostCell(in, n, i+di[d], j+dj[d]);
+					if (g[0] < 0) continue;
+					across[0] = (row0+i+di[d] < 0) ? side : (row0+i+di[d] >= side) ? -side : 0;
+					across[1] = (col0+j+dj[d] < 0) ? side : (col0+j+dj[d] >= side) ? -side : 0;
+					if (g[0] < label[c]){
+						label[c]     = g[0];
+						shift[2*c]   = g[1] + across[0];
+						shift[2*c+1] = g[2] + across[1];
+						changed      = 1;
+					}
+					else if ((g[0] == label[c]) && ((shift[2*c] != g[1] + across[0]) || (shift[2*c+1] != g[2] + across[1]))) wraps[c] = 1;
+				}
+			}
+		}
+		MPI_Allreduce(&changed, &anychanged, 1, MPI_INT, MPI_LOR, comm);
+	} while (anychanged);			//In the last round nothing changed, so wraps holds the clusters that met themselves with another shift
+
+	/*3. The pieces of the clusters in the block, sent to the process of their label (the one with the first cell of the cluster)*/
+	records = malloc((clusters + 1) * CLUSTER_FIELDS * sizeof(long long));
+	for (c = 0; c < clusters; c++){
+		r = records + c*CLUSTER_FIELDS;
+		r[CLUSTER_LABEL]  = label[c];
+		r[CLUSTER_CELLS]  = 0;
+		r[CLUSTER_TOP]    = r[CLUSTER_LEFT] = LLONG_MAX;
+		r[CLUSTER_BOTTOM] = r[CLUSTER_RIGHT] = LLONG_MIN;
+		r[CLUSTER_ROWS]   = r[CLUSTER_COLUMNS] = 0;
+		r[CLUSTER_WRAPS]  = wraps[c];
+	}
+	for (i = 0; i < n; i++){
+		for (j = 0; j < n; j++){
+			c = clusterOf(parent, n, i, j);
+			if (c < 0) continue;
+			r = records + c*CLUSTER_FIELDS;
+			across[0] = row0 + i + shift[2*c];			//The cell unwrapped
+			across[1] = col0 + j + shift[2*c+1];
+			if (across[0] < r[CLUSTER_TOP]) r[CLUSTER_TOP] = across[0];
+			if (across[1] < r[CLUSTER_LEFT]) r[CLUSTER_LEFT] = across[1];
+			if (across[0] > r[CLUSTER_BOTTOM]) r[CLUSTER_BOTTOM] = across[0];
+			if (across[1] > r[CLUSTER_RIGHT]) r[CLUSTER_RIGHT] = across[1];
+			r[CLUSTER_CELLS]++;
+			r[CLUSTER_ROWS]    += across[0];
+			r[CLUSTER_COLUMNS] += across[1];
+		}
+	}
+	free(parent);
+	free(label);
+	free(shift);
+	free(wraps);
+	for (d = 0; d < 8; d++){
+		free(out[d]);
+		free(in[d]);
+	}
+
+	sendcounts = calloc(processes, sizeof(int));
+	senddispls = malloc(processes * sizeof(int));
+	recvcounts = malloc(processes * sizeof(int));
+	recvdispls = malloc(processes * sizeof(int));
+	place      = malloc(processes * sizeof(int));
+	for (c = 0; c < clusters; c++)
+		sendcounts[records[c*CLUSTER_FIELDS + CLUSTER_LABEL] / cellsperblock] += CLUSTER_FIELDS;
+	for (k = 0, m = 0; k < processes; k++){
+		senddispls[k] = place[k] = m;
+		m += sendcounts[k];
+	}
+	sent = malloc((m + 1) * sizeof(long long));
+	for (c = 0; c < clusters; c++){
+		k = records[c*CLUSTER_FIELDS + CLUSTER_LABEL] / cellsperblock;
+		memcpy(sent + place[k], records + c*CLUSTER_FIELDS, CLUSTER_FIELDS * sizeof(long long));
+		place[k] += CLUSTER_FIELDS;
+	}
+	free(records);
+	MPI_Alltoall(sendcounts, 1, MPI_INT, recvcounts, 1, MPI_INT, comm);
+	for (k = 0, m = 0; k < processes; k++){
+		recvdispls[k] = m;
+		m += recvcounts[k];
+	}
+	received = malloc((m + 1) * sizeof(long long));
+	MPI_Alltoallv(sent, sendcounts, senddispls, MPI_LONG_LONG, received, recvcounts, recvdispls, MPI_LONG_LONG, comm);
+	free(sent);
+
+	/*The pieces of the same cluster are joined (sorted by label, the label is the first field)*/
+	qsort(received, m / CLUSTER_FIELDS, CLUSTER_FIELDS * sizeof(long long), compareLabels);
+	for (k = 0; k < m; k += CLUSTER_FIELDS){
+		r = received + k;
+		if ((mine > 0) && (received[(mine-1)*CLUSTER_FIELDS + CLUSTER_LABEL] == r[CLUSTER_LABEL])){
+			long long *s = received + (mine-1)*CLUSTER_FIELDS;
+			if (r[CLUSTER_TOP] < s[CLUSTER_TOP]) s[CLUSTER_TOP] = r[CLUSTER_TOP];
+			if (r[CLUSTER_LEFT] < s[CLUSTER_LEFT]) s[CLUSTER_LEFT] = r[CLUSTER_LEFT];
+			if (r[CLUSTER_BOTTOM] > s[CLUSTER_BOTTOM]) s[CLUSTER_BOTTOM] = r[CLUSTER_BOTTOM];
+			if (r[CLUSTER_RIGHT] > s[CLUSTER_RIGHT]) s[CLUSTER_RIGHT] = r[CLUSTER_RIGHT];
+			s[CLUSTER_CELLS]   += r[CLUSTER_CELLS];
+			s[CLUSTER_ROWS]    += r[CLUSTER_ROWS];
+			s[CLUSTER_COLUMNS] += r[CLUSTER_COLUMNS];
+			s[CLUSTER_WRAPS]   |= r[CLUSTER_WRAPS];
+		}
+		else {
+			if (mine*CLUSTER_FIELDS != k) memmove(received + mine*CLUSTER_FIELDS, r, CLUSTER_FIELDS * sizeof(long long));
+			mine++;
+		}
+	}
+
+	/*The clusters are numbered in the order of the processes and written with one collective call, each process after the one before*/
+	MPI_Exscan(&mine, &first, 1, MPI_LONG, MPI_SUM, comm);
+	if (my_rank == 0) first = 0;
+	MPI_Allreduce(&mine, &all, 1, MPI_LONG, MPI_SUM, comm);
+	text   = malloc((mine + 1) * LINE + sizeof(header));
+	length = 0;
+	if (my_rank == 0) length = sprintf(text, "%s", header);
+	/*The box is moved by whole sides so that its top left cell is on the board (its bottom and right are past the side if it crosses*/
+	/*it) and the centroid is taken back on the board*/
+	for (c = 0; c < mine; c++){
+		r = received + c*CLUSTER_FIELDS;
+		for (k = 0; k < 2; k++){
+			across[k] = (r[CLUSTER_TOP+k] >= 0) ? r[CLUSTER_TOP+k] / side : -((side - 1 - r[CLUSTER_TOP+k]) / side);
+			r[CLUSTER_TOP+k]    -= across[k]*side;
+			r[CLUSTER_BOTTOM+k] -= across[k]*side;
+			centre[k] = fmod((double)r[CLUSTER_ROWS+k] / r[CLUSTER_CELLS], (double)side);
+			if (centre[k] < 0) centre[k] += side;
+		}
+		length += sprintf(text + length, "%ld,%lld,%lld,%lld,%lld,%lld,%.3f,%.3f,%lld\n", first + c, r[CLUSTER_CELLS], r[CLUSTER_TOP], r[CLUSTER_LEFT],
+						r[CLUSTER_BOTTOM], r[CLUSTER_RIGHT], centre[0], centre[1], r[CLUSTER_WRAPS]);
+	}
+	free(received);
+	free(sendcounts);
+	free(senddispls);
+	free(recvcounts);
+	free(recvdispls);
+	free(place);
+
+	k = (MPI_File_open(comm, (char *)filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fp) == MPI_SUCCESS);
+	if (k){
+		MPI_File_set_size(fp, 0);
+		MPI_File_write_ordered(fp, text, length, MPI_CHAR, MPI_STATUS_IGNORE);
+		MPI_File_close(&fp);
+	}
+	free(text);
+	return k ? all : -1;
+}
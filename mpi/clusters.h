@@ -0,0 +1,15 @@
+#ifndef __clusters__
+#define __clusters__
+
+#include "mpi.h"
+
+
+/*Fields of a cluster while it is merged: its label, cells, bounding box, the sums of the rows and the columns of its cells (all of*/
+/*them unwrapped from the torus) and whether it wraps around the torus*/
+#define CLUSTER_FIELDS 9
+
+
+long clustersWrite(const char *filename, char **cells, int n, int frame, int threads, int my_rank, int SideProcesses, int neighbours[8], MPI_Comm comm);
+
+
+#endif
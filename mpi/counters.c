@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "counters.h"
+#ifdef __linux__
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+
+static int fds[COUNTERS] = {-1, -1, -1, -1};
+static int slot[COUNTERS];				//Position of each counter in what the group leader reads
+static int leader = -1, opened = 0;
+
+
+
+/*Open the counters of the calling thread (only user space) as one group, so that they are started and stopped together*/
+/*Returns a mask with a bit for every counter that exists (0 if the kernel or the CPU, e.g. in a virtual machine, has none)*/
+int countersOpen(void)
+{
+	int  available = 0;
+#ifdef __linux__
+	int  i;
+	struct perf_event_attr attr;
+	unsigned long long config[COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+
+	for (i = 0; i < COUNTERS; i++){
+		memset(&attr, 0, sizeof(attr));
+		attr.type           = PERF_TYPE_HARDWARE;
+		attr.size           = sizeof(attr);
+		attr.config         = config[i];
+		attr.disabled       = (leader == -1);			//Only the leader is disabled, the others follow it
+		attr.exclude_kernel = 1;
+		attr.exclude_hv     = 1;
+		attr.read_format    = PERF_FORMAT_GROUP;
+		fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, leader, 0);
+		if (fds[i] == -1) continue;				//This counter does not exist here, the others are still kept
+		if (leader == -1) leader = fds[i];
+		slot[i] = opened++;
+		available |= 1 << i;
+	}
+#endif
+	return available;
+}
+
+
+
+/*Start counting from zero (just before a kernel)*/
+void countersStart(void)
+{
+#ifdef __linux__
+	if (leader == -1) return;
+	ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+	ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+}
+
+
+
+/*Stop counting (just after a kernel) and add the counters and the cells computed to the kernel's totals*/
+void countersStop(long long counts[COUNTERS+1], long long cells)
+{
+	int  i;
+	unsigned long long values[COUNTERS+1];			//The number of counters and their values
+
+	counts[COUNT_CELLS] += cells;
+#ifdef __linux__
+	if (leader == -1) return;
+	ioctl(leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	if (read(leader, values, sizeof(values)) < (ssize_t)((1 + opened) * sizeof(unsigned long long))) return;
+	for (i = 0; i < COUNTERS; i++)
+		if (fds[i] != -1) counts[i] += values[1 + slot[i]];
+#endif
+}
+
+
+
+/*Close the counters*/
+void countersClose(void)
+{
+	int  i;
+
+	for (i = 0; i < COUNTERS; i++){
+		if (fds[i] != -1) close(fds[i]);
+		fds[i] = -1;
+	}
+	leader = -1;
+	opened = 0;
+}
+
+
+
+/*Print instructions per cycle and cycles, LLC misses and branch misses per cell for every kernel (the totals of all processes)*/
+void countersShow(long long counts[][COUNTERS+1], const char *names[], int kernels, int available)
+{
+	int  k;
+	double cells;
+
+	if (available == 0){
+		printf("Hardware counters are not available (perf_event_open failed, see /proc/sys/kernel/perf_event_paranoid)\n");
+		printf("--------------------------------------------------------------\n");
+		return;
+	}
+	printf("Kernel              Cells        IPC  Cycles/cell  LLC misses/cell  Branch misses/cell\n");
+	for (k = 0; k < kernels; k++){
+		if (counts[k][COUNT_CELLS] == 0) continue;
+		cells = (double)counts[k][COUNT_CELLS];
+		printf("%-16s %12lld", names[k], counts[k][COUNT_CELLS]);
+		if ((available & (1 << COUNT_CYCLES)) && (available & (1 << COUNT_INSTRUCTIONS)) && (counts[k][COUNT_CYCLES] > 0))
+			printf(" %8.3f", (double)counts[k][COUNT_INSTRUCTIONS] / counts[k][COUNT_CYCLES]);
+		else printf(" %8s", "n/a");
+		if (available & (1 << COUNT_CYCLES)) printf(" %12.3f", counts[k][COUNT_CYCLES] / cells);
+		else printf(" %12s", "n/a");
+		if (available & (1 << COUNT_LLC_MISSES)) printf(" %16.5f", counts[k][COUNT_LLC_MISSES] / cells);
+		else printf(" %16s", "n/a");
+		if (available & (1 << COUNT_BRANCH_MISSES)) printf(" %19.5f", counts[k][COUNT_BRANCH_MISSES] / cells);
+		else printf(" %19s", "n/a");
+		printf("\n");
+	}
+	printf("--------------------------------------------------------------\n");
+}
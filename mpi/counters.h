@@ -0,0 +1,17 @@
+#ifndef __counters__
+#define __counters__
+
+
+/*Hardware counters kept for every kernel (-c in cmd), the last value of a kernel's array is the number of cells it computed*/
+#define COUNTERS 4
+enum {COUNT_CYCLES, COUNT_INSTRUCTIONS, COUNT_LLC_MISSES, COUNT_BRANCH_MISSES, COUNT_CELLS};
+
+
+int  countersOpen(void);
+void countersStart(void);
+void countersStop(long long counts[COUNTERS+1], long long cells);
+void countersClose(void);
+void countersShow(long long counts[][COUNTERS+1], const char *names[], int kernels, int available);
+
+
+#endif
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "gol.h"
+#include "generations.h"
+#include "memory.h"
+
+
+
+/*Build the transition table of a Generations rule given as B/S/C (e.g. B2/S/C3 for Brian's Brain, B2/S345/C4 for Star Wars)*/
+/*State 0 is dead, 1 is alive and 2..C-1 are dying, table[state][live neighbours] is the state in the next generation*/
+int parseGenRule(const char *rulestring, char table[GEN_MAX_STATES][9], int *states)
+{
+	int  s, n, C;
+	char rule[2][9], *copy, *p;
+
+	copy = strdup(rulestring);
+	p = strchr(copy, 'C');
+	if (p == NULL) p = strchr(copy, 'c');
+	if ((p == NULL) || (p == copy) || (p[-1] != '/')){
+		free(copy);
+		return -1;
+	}
+	C = atoi(p+1);						//Number of states
+	p[-1] = '\0';						//The B/S part of the rule
+	if ((C < 2) || (C > GEN_MAX_STATES) || (gol_parse_rule(copy, rule) != 0)){
+		free(copy);
+		return -1;
+	}
+	free(copy);
+
+	for (n = 0; n < 9; n++){
+		table[0][n] = rule[0][n];									//A dead cell is born
+		table[1][n] = rule[1][n] ? 1 : ((C > 2) ? 2 : 0);			//A live cell survives, or else starts dying
+		for (s = 2; s < C; s++)
+			table[s][n] = (s+1) % C;								//A dying cell keeps dying until it is dead
+	}
+	*states = C;
+	return 0;
+}
+
+
+
+/*Bits of a packed cell (2 bits hold up to 4 states, 4 bits up to 16)*/
+int packedBits(int states)
+{
+	return (states <= 4) ? 2 : 4;
+}
+
+
+
+/*Bytes of a packed row of n cells*/
+int packedBytes(int n, int bits)
+{
+	return (n*bits + 7) / 8;
+}
+
+
+
+/*Create a packed 2D array (rows of packed cells) with contiguous memory, initialized with 0s*/
+unsigned char **allocatePacked(int rows, int bytes)
+{
+	int i;
+	unsigned char *p, **array;
+
+	p = allocateCells((size_t)rows*bytes*sizeof(unsigned char));
+	memset(p, 0, (size_t)rows*bytes);
+	array = malloc(rows * sizeof(unsigned char*));
+	for (i = 0; i < rows; i++)
+		array[i] = &(p[i*bytes]);
+	return array;
+}
+
+
+
+/*Delete a packed 2D array created in the way above*/
+void deletePacked(unsigned char ***array)
+{
+	releaseCells(&((*array)[0][0]));
+	free(*array);
+}
+
+
+
+/*The cell j of a packed row (the first cell of each byte lies in its low bits)*/
+int getCell(const unsigned char *row, int j, int bits)
+{
+	int per = 8 / bits;
+	return (row[j/per] >> ((j%per)*bits)) & ((1 << bits) - 1);
+}
+
+
+
+/*Set the cell j of a packed row*/
+void setCell(unsigned char *row, int j, int bits, int value)
+{
+	int per = 8 / bits, shift = (j%per)*bits;
+	row[j/per] = (row[j/per] & ~(((1 << bits) - 1) << shift)) | (value << shift);
+}
+
+
+
+/*Pack n cells (one char each) into the cells first..first+n-1 of a packed row*/
+void packRow(const char *cells, unsigned char *row, int first, int n, int bits)
+{
+	int j;
+	for (j = 0; j < n; j++)
+		setCell(row, first+j, bits, cells[j]);
+}
+
+
+
+/*Unpack the cells first..first+n-1 of a packed row into n cells (one char each)*/
+void unpackRow(const unsigned char *row, char *cells, int first, int n, int bits)
+{
+	int j, mask = (1 << bits) - 1;
+
+	if (bits == 2){
+		for (j = 0; j < n; j++)
+			cells[j] = (row[(first+j) >> 2] >> (((first+j) & 3) << 1)) & mask;
+	}
+	else {
+		for (j = 0; j < n; j++)
+			cells[j] = (row[(first+j) >> 1] >> (((first+j) & 1) << 2)) & mask;
+	}
+}
+
+
+
+/*Pack a n x n array into the interior of a packed block with a ghost frame one cell wide*/
+void packBlock(char **cells, unsigned char **pad, int n, int bits)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		packRow(cells[i], pad[i+1], 1, n, bits);
+}
+
+
+
+/*Unpack the interior of a packed block with a ghost frame into a n x n array*/
+void unpackBlock(unsigned char **pad, char **cells, int n, int bits)
+{
+	int i;
+	for (i = 0; i < n; i++)
+		unpackRow(pad[i+1], cells[i], 1, n, bits);
+}
+
+
+
+/*Copy the opposite sides of a packed block in its ghost frame, so that the n x n interior wraps around*/
+void fillPackedGhosts(unsigned char **pad, int n, int bits)
+{
+	int i, bytes = packedBytes(n+2, bits);
+
+	for (i = 1; i <= n; i++){
+		setCell(pad[i], 0, bits, getCell(pad[i], n, bits));			//Left ghost column from the right side
+		setCell(pad[i], n+1, bits, getCell(pad[i], 1, bits));		//Right ghost column from the left side
+	}
+	memcpy(pad[0], pad[n], bytes);									//Whole rows, so the corners come along
+	memcpy(pad[n+1], pad[1], bytes);
+}
+
+
+
+/*The rows [row0,row1) of a packed block with a ghost frame evolve under a Generations rule*/
+/*Each row is unpacked once into a small rolling window of 3 rows (scratch holds 5*(n+2) chars), so only packed rows travel through memory*/
+void evolve_generations(unsigned char **old_gen, unsigned char **new_gen, int row0, int row1, int n, int bits, char table[GEN_MAX_STATES][9], char *scratch, int *allzeros, int *change)
+{
+	int  i, j, neighbours, bytes = packedBytes(n+2, bits);
+	char *up, *mid, *down, *next, *colsum, *help;
+
+	if (row0 >= row1) return;
+
+	up     = scratch;
+	mid    = scratch + (n+2);
+	down   = scratch + 2*(n+2);
+	next   = scratch + 3*(n+2);
+	colsum = scratch + 4*(n+2);
+	unpackRow(old_gen[row0-1], up, 0, n+2, bits);
+	unpackRow(old_gen[row0], mid, 0, n+2, bits);
+	next[0] = next[n+1] = 0;
+
+	for (i = row0; i < row1; i++)
+	{
+		unpackRow(old_gen[i+1], down, 0, n+2, bits);
+
+		for (j = 0; j < n+2; j++)									//Live cells (state 1) of each column of the window
+			colsum[j] = (up[j] == 1) + (mid[j] == 1) + (down[j] == 1);
+
+		for (j = 1; j <= n; j++)
+		{
+			neighbours = colsum[j-1] + colsum[j] + colsum[j+1] - (mid[j] == 1);
+			next[j] = table[(int)mid[j]][neighbours];				//Assign new states from the rule's transition table
+
+			if (next[j] != 0) *allzeros = 1;
+			if (next[j] != mid[j]) *change = 1;
+		}
+
+		memset(new_gen[i], 0, bytes);								//Pack the new row (its ghost cells are refilled before the next generation)
+		for (j = 0; j < n+2; j++)
+			new_gen[i][(j*bits) >> 3] |= next[j] << ((j*bits) & 7);
+
+		help = up;													//Roll the window one row down
+		up   = mid;
+		mid  = down;
+		down = help;
+	}
+}
@@ -0,0 +1,23 @@
+#ifndef __generations__
+#define __generations__
+
+
+#define GEN_MAX_STATES 16
+
+
+int parseGenRule(const char *rulestring, char table[GEN_MAX_STATES][9], int *states);
+int packedBits(int states);
+int packedBytes(int n, int bits);
+unsigned char **allocatePacked(int rows, int bytes);
+void deletePacked(unsigned char ***array);
+int getCell(const unsigned char *row, int j, int bits);
+void setCell(unsigned char *row, int j, int bits, int value);
+void packRow(const char *cells, unsigned char *row, int first, int n, int bits);
+void unpackRow(const unsigned char *row, char *cells, int first, int n, int bits);
+void packBlock(char **cells, unsigned char **pad, int n, int bits);
+void unpackBlock(unsigned char **pad, char **cells, int n, int bits);
+void fillPackedGhosts(unsigned char **pad, int n, int bits);
+void evolve_generations(unsigned char **old_gen, unsigned char **new_gen, int row0, int row1, int n, int bits, char table[GEN_MAX_STATES][9], char *scratch, int *allzeros, int *change);
+
+
+#endif
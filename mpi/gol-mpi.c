@@ -5,9 +5,21 @@
 #include <math.h>
 #include "mpi.h"
 #include "functions.h"
+#include "gol.h"
+#include "ltl.h"
+#include "generations.h"
+#include "halo.h"
+#include "trace.h"
+#include "counters.h"
+#include "stats.h"
+#include "memory.h"
+#include "loader.h"
+#include "tasks.h"
+#include "clusters.h"
+#include "search.h"
 
 
-#define BUFSIZE 64
+#define PAIRS 1024			//Live cells a process keeps room for at first while it scans its part of the input file
 
 
 
@@ -16,13 +28,18 @@ int main(int argc, char *argv[])
 {
 	int  i, j, N = 8, SideBlocks, SideProcesses, generations = 3;
 	int  processes, my_rank, output = 0, doom = 0;
-	int  nozero, diff, allzeros, change;
-	char **cells, **blocks;
-	FILE *fp = NULL;
+	int  nozero, diff, allzeros, change, radius = 0, frame, *colsum = NULL, states = 2, bits = 0;
+	char **cells, **blocks, rule[2][9], *rulestring = "B3/S23", *ltlrule = NULL, *tracefile = NULL, *dumpfile = NULL, gentable[GEN_MAX_STATES][9];
+	char *inputfile = NULL, *statsfile = NULL, *clusterfile = NULL, *patterns = NULL, *patternfile = "patterns.csv";
+	long clusters = 0;
+	int  tiling = 0, thread_count = 2, provided, evolving, layout = TILES_HILBERT;
+	int  counting = 0, available = 0, allavailable, every = 1;
+	long long kernelcounts[2][COUNTERS+1] = {{0}}, allcounts[2][COUNTERS+1], innercells, sidecells;
+	const char *kernels[2] = {"evolve_inner", "evolve_sides"};
 
 
 	/*Initialize MPI to share the calculations between different processors*/
-	MPI_Init(&argc, &argv);
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);		//With tiles (-x) only the main thread of the pool calls MPI
 	MPI_Comm_size(MPI_COMM_WORLD, &processes);
 	MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
 
@@ -31,38 +48,138 @@ int main(int argc, char *argv[])
 	for (i = 0; i < argc; i++){
 		if (!strcmp(argv[i], "-n")) N = atoi(argv[++i]);
 		else if (!strcmp(argv[i], "-g")) generations = atoi(argv[++i]);
-		else if (!strcmp(argv[i], "-i")) fp = fopen(argv[++i], "r");
+		else if (!strcmp(argv[i], "-i")) inputfile = argv[++i];
 		else if (!strcmp(argv[i], "-o1")) output = 1;
 		else if (!strcmp(argv[i], "-o2")) output = 2;
 		else if (!strcmp(argv[i], "-d")) doom = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-r")) rulestring = argv[++i];
+		else if (!strcmp(argv[i], "-T")) tracefile = argv[++i];
+		else if (!strcmp(argv[i], "-w")) dumpfile = argv[++i];
+		else if (!strcmp(argv[i], "-c")) counting = 1;
+		else if (!strcmp(argv[i], "-S")) statsfile = argv[++i];
+		else if (!strcmp(argv[i], "-x")) tiling = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-t")) thread_count = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-C")) clusterfile = argv[++i];
+		else if (!strcmp(argv[i], "-p")) patterns = argv[++i];
+		else if (!strcmp(argv[i], "-F")) patternfile = argv[++i];
+		else if (!strcmp(argv[i], "-e")) every = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-L")){
+			i++;
+			if (!strcmp(argv[i], "rows")) layout = TILES_ROWS;
+			else if (!strcmp(argv[i], "morton")) layout = TILES_MORTON;
+			else if (!strcmp(argv[i], "hilbert")) layout = TILES_HILBERT;
+			else layout = -1;
+		}
+	}
+
+	/*Build the transition table of the rule (Conway's B3/S23 by default, or Larger than Life if it starts with the range R), or else exit*/
+	if (rulestring[0] == 'R'){
+		ltlrule = parseLtLRule(rulestring, &radius);
+		if (ltlrule == NULL){
+			if (my_rank == 0) fprintf(stderr, "Invalid rule %s (e.g. R5,C0,M1,S34..58,B34..45,NM with range up to %d)\n", rulestring, LTL_MAX_RADIUS);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+	}
+	else if ((strchr(rulestring, 'C') != NULL) || (strchr(rulestring, 'c') != NULL)){
+		if (parseGenRule(rulestring, gentable, &states) != 0){
+			if (my_rank == 0) fprintf(stderr, "Invalid rule %s (e.g. B2/S/C3 with up to %d states)\n", rulestring, GEN_MAX_STATES);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+		if (states == 2) memcpy(rule, gentable, sizeof(rule));		//Two states (/C2) is a plain B/S rule
+		bits = packedBits(states);			//Generations rules keep their cells packed (2 or 4 bits each)
+	}
+	else if (gol_parse_rule(rulestring, rule) != 0){
+		if (my_rank == 0) fprintf(stderr, "Invalid rule %s (B/S notation is expected, e.g. B36/S23)\n", rulestring);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+
+	/*The kernels of the Generations rules work on packed cells and keep no statistics*/
+	if ((statsfile != NULL) && (states > 2)){
+		if (my_rank == 0) fprintf(stderr, "Statistics (-S) are kept only for B/S and Larger than Life rules\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+
+	/*The patterns and their phases are found with the rule of the board, in live cells of two states (-p in cmd)*/
+	if (patterns != NULL){
+		if ((radius > 0) || (states > 2)){
+			if (my_rank == 0) fprintf(stderr, "Patterns (-p) are searched only with B/S rules\n");
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+		if ((every < 1) || (searchPatterns(patterns, rule) != 0)){
+			if (my_rank == 0) fprintf(stderr, "Invalid patterns %s (names e.g. glider,block or files of up to %dx%d cells, searched every -e >= 1 generations)\n", patterns, SEARCH_MAX_SIDE, SEARCH_MAX_SIDE);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+	}
+
+	/*The tiles evolve on their own, so nothing that needs all the blocks at the same generation goes with them*/
+	if ((tiling > 0) && ((radius > 0) || (states > 2) || (output == 2) || (doom == 1) || (statsfile != NULL) || counting || (tracefile != NULL) || (patterns != NULL))){
+		if (my_rank == 0) fprintf(stderr, "The tiles (-x) evolve only B/S rules, without -o2, -d 1, -S, -c, -T and -p\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	if ((tiling > 0) && ((tiling > TASKS_MAX_SIDE) || (thread_count < 1) || (provided < MPI_THREAD_FUNNELED))){
+		if (my_rank == 0) fprintf(stderr, "The tiles (-x) need up to %d tiles per side, at least one thread (-t) and an MPI library with threads\n", TASKS_MAX_SIDE);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	if (layout < 0){
+		if (my_rank == 0) fprintf(stderr, "The layout of the tiles (-L) is rows, morton or hilbert\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
 	}
 
 	/*Allocate memory for cells array and initialize it with 0s or randomly*/
-	if (fp == NULL){
+	if (inputfile == NULL){
 		srand(time(NULL));
 		cells = allocateArray(N, 1);
 	}
 	else cells = allocateArray(N, 0);
 
 
-	/*Allocate memory for cells array, initialize it and check if the flag values are proper*/
-	if (my_rank == 0)
-	{
-		/*Read from input file the position of initial live cells (if there is input file)*/
-		if (fp != NULL){
-			char line[BUFSIZE], *token, delim[2] = " ";
-			fgets(line, BUFSIZE, fp);
-			while (!feof(fp)){							//Till the end of the file read from it
-				token = strtok(line, delim);
-				i = atoi(token);
-				token = strtok(NULL, delim);
-				j = atoi(token);
-				cells[i][j] = 1;						//Assign a live cell in the coordinates given
-				fgets(line, BUFSIZE, fp);
+	/*Read from input file the position of initial live cells (if there is input file). Every process maps the file and scans only its*/
+	/*own part of the lines, and the main one gathers the live cells that they found*/
+	if (inputfile != NULL){
+		mapped input;
+		int  k, found = 0, room = PAIRS, *pairs = malloc(2*room * sizeof(int)), pieces[processes], places[processes], all = 0, *allpairs = NULL;
+
+		if (mapInput(inputfile, &input) != 0){
+			if (my_rank == 0) fprintf(stderr, "Cannot read the input file %s\n", inputfile);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+		splitInput(&input, my_rank, processes);
+		while (nextCoordinates(&input, &i, &j)){
+			if ((i < 0) || (j < 0) || (i >= N) || (j >= N)){
+				fprintf(stderr, "The cell %d %d of %s is out of the %d x %d board\n", i, j, inputfile, N, N);
+				MPI_Abort(MPI_COMM_WORLD, 1);
 			}
-			fclose(fp);									//Close the file
+			if (found == room){
+				room *= 2;
+				pairs = realloc(pairs, 2*room * sizeof(int));
+			}
+			pairs[2*found]   = i;
+			pairs[2*found+1] = j;
+			found++;
 		}
+		unmapInput(&input);
+
+		found *= 2;
+		MPI_Gather(&found, 1, MPI_INT, pieces, 1, MPI_INT, 0, MPI_COMM_WORLD);
+		if (my_rank == 0){
+			for (k = 0; k < processes; k++){
+				places[k] = all;
+				all += pieces[k];
+			}
+			allpairs = malloc((all + 2) * sizeof(int));
+		}
+		MPI_Gatherv(pairs, found, MPI_INT, allpairs, pieces, places, MPI_INT, 0, MPI_COMM_WORLD);
+		if (my_rank == 0){
+			for (k = 0; k < all; k += 2)
+				cells[allpairs[k]][allpairs[k+1]] = 1;		//Assign a live cell in the coordinates given
+			free(allpairs);
+		}
+		free(pairs);
+	}
 
+	/*Check if the flag values are proper*/
+	if (my_rank == 0)
+	{
 		/*Check if the number of processes are powers, or else exit*/
 		float blockside = sqrt((float)processes);
 		if ((blockside - (int)blockside) != 0){
@@ -72,14 +189,24 @@ int main(int argc, char *argv[])
 	}
 
 	/*Start timer - finish just before MPI_Finalize()*/
-	double start, finish;
+	double start, finish, t = 0.0;
 	MPI_Barrier(MPI_COMM_WORLD);
 	start = MPI_Wtime();
+	if (tracefile != NULL) traceStart(tracefile, generations, start);		//Time every phase of every generation (-T in cmd)
 
 	/*Allocate memory for blocks in every process*/
 	SideProcesses = (int) sqrt((float)processes);
 	SideBlocks = (int) (N / SideProcesses);
-	blocks = allocateArray(SideBlocks, 0);
+	if (SideBlocks < radius){
+		if (my_rank == 0) fprintf(stderr, "The blocks must be at least as wide as the range of the rule\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	if ((tiling > 0) && (SideBlocks % tiling != 0)){
+		if (my_rank == 0) fprintf(stderr, "The side of the blocks (%d) must be a multiple of the tiles per side (-x)\n", SideBlocks);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	frame  = (radius > 0) ? radius : ((states > 2) ? 0 : 1);
+	blocks = allocateArray(SideBlocks+2*frame, 0);			//A ghost frame surrounds each block (radius cells wide for Larger than Life, one cell for B/S rules)
 
 
 	/*Create a datatype for the subarrays (blocks) of the global cells array*/
@@ -91,6 +218,17 @@ int main(int argc, char *argv[])
 	MPI_Type_create_resized(type, 0, SideBlocks*sizeof(char), &subarraytype);				//Extend the above type
 	MPI_Type_commit(&subarraytype);															//Commit the subarray datatype
 
+	/*With a ghost frame, only the interior of the blocks is scattered and gathered*/
+	int blocksizes[2]  = {SideBlocks+2*frame, SideBlocks+2*frame};
+	int blockstarts[2] = {frame, frame};
+	int blockcount = SideBlocks*SideBlocks;
+	MPI_Datatype blocktype = MPI_CHAR;
+	if (frame > 0){
+		MPI_Type_create_subarray(2, blocksizes, subsizes, blockstarts, MPI_ORDER_C, MPI_CHAR, &blocktype);
+		MPI_Type_commit(&blocktype);
+		blockcount = 1;
+	}
+
 	/*Scatter the array to all processors*/
 	int counts[processes], starting_point[processes], displacement;
 	if (my_rank == 0){
@@ -105,7 +243,7 @@ int main(int argc, char *argv[])
 			displacement += (SideBlocks-1)*SideProcesses;				//Each starting point is at every block extend
 		}
 	}
-	MPI_Scatterv(&(cells[0][0]), counts, starting_point, subarraytype, &(blocks[0][0]), N*N/processes, MPI_CHAR, 0, MPI_COMM_WORLD);
+	MPI_Scatterv(&(cells[0][0]), counts, starting_point, subarraytype, &(blocks[0][0]), blockcount, blocktype, 0, MPI_COMM_WORLD);
 
 
 	/*The subarrays must arranged as Cartesian coordinate structure for proper communication between the local ones*/
@@ -144,69 +282,173 @@ int main(int argc, char *argv[])
 	neighbour[0] = coords[0];
 	neighbour[1] = coords[1] - 1;
 	MPI_Cart_rank(new_comm, neighbour, &left);				//Left
+	int neighbours[8] = {upleft, up, upright, right, downright, down, downleft, left};
+
+	/*With a Generations rule the blocks are packed, with a ghost frame one cell wide (blocks are only used to scatter and gather)*/
+	unsigned char **packed = NULL, **packed_new = NULL, **packed_swap, *colbuffer = NULL;
+	char *scratch = NULL;
+	if (states > 2){
+		packed     = allocatePacked(SideBlocks+2, packedBytes(SideBlocks+2, bits));
+		packed_new = allocatePacked(SideBlocks+2, packedBytes(SideBlocks+2, bits));
+		colbuffer  = malloc(4*packedBytes(SideBlocks, bits) * sizeof(unsigned char));
+		scratch    = malloc(5*(SideBlocks+2) * sizeof(char));
+		packBlock(blocks, packed, SideBlocks, bits);
+	}
 
 
-	/*Declare waitall() variables and arrays for copy a line or cell (neighbour_border) and receive (received_border)*/
-	MPI_Request request[8];
-	MPI_Status  status[8];
-	char *neighbour_border, side_border[SideBlocks], **received_border, *help1, **help2;
-	neighbour_border = malloc(SideBlocks * sizeof(char));
-	help1 = neighbour_border;											//Copy array - neighbour_border
-	received_border = malloc(8 * sizeof(char*));
-	for (i = 0; i < 8; i++)												//Paste (receive) array - received_border
-		received_border[i] = malloc(SideBlocks * sizeof(char));
-	help2 = received_border;
+	/*Declare waitall() variables for the 8 sends and the 8 receives of the ghost frame*/
+	MPI_Request request[16];
+	MPI_Status  status[16];
 
 	/*A temporary array to find the new values of cells for the next generation and then copy it to blocks array*/
 	char **new_gen, **swap;
-	new_gen = allocateArray(SideBlocks, 0);
+	new_gen = allocateArray(SideBlocks+2*frame, 0);
+
+	/*Datatypes for the sides and corners of the ghost frame and the column sums of a Larger than Life rule*/
+	MPI_Datatype halotypes[3];
+	if (frame > 0) createHaloTypes(SideBlocks, frame, halotypes);
+	if (radius > 0) colsum = malloc((SideBlocks+2*radius) * sizeof(int));
+
+
+	/*Hardware counters around the kernels of the inner and the side cells in every process (-c in cmd)*/
+	if (states > 2) innercells = (long long)(SideBlocks-2)*SideBlocks;
+	else if (radius > 0) innercells = (SideBlocks >= 2*radius) ? (long long)(SideBlocks-2*radius)*(SideBlocks-2*radius) : 0;
+	else innercells = (long long)(SideBlocks-2)*(SideBlocks-2);
+	sidecells = (long long)SideBlocks*SideBlocks - innercells;
+	if (counting) available = countersOpen();
+
+	/*Population, births, deaths and bounding box of every generation, counted by the kernels in each block (-S in cmd)*/
+	gol_stats blockstats, *stats = NULL;
+	int  row0 = (my_rank / SideProcesses) * SideBlocks - frame, col0 = (my_rank % SideProcesses) * SideBlocks - frame;		//Board place of blocks[0][0]
+	if (statsfile != NULL){
+		if (statsStart(statsfile, my_rank, MPI_COMM_WORLD) != 0){
+			fprintf(stderr, "Cannot write the statistics in %s\n", statsfile);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+		stats = &blockstats;
+	}
 
+	/*Every process searches its own block (with a halo as wide as the largest pattern) and writes what it found (-p in cmd)*/
+	if (patterns != NULL){
+		j = searchStart(patternfile, SideBlocks, neighbours, my_rank, MPI_COMM_WORLD);
+		if (j != 0){
+			if (my_rank == 0){
+				if (j == -1) fprintf(stderr, "Cannot write the patterns in %s\n", patternfile);
+				else fprintf(stderr, "The blocks (%d cells per side) are narrower than the largest pattern\n", SideBlocks);
+			}
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+	}
+
+
+	/*Over-decomposition (-x in cmd): the tiles of the block evolve on their own (tasks.c), with no step of all the processes together*/
+	evolving = generations;
+	if (tiling > 0){
+		runTiles(blocks, SideBlocks, tiling, layout, thread_count, generations, rule, my_rank, SideProcesses, MPI_COMM_WORLD);
+		evolving = 0;
+	}
+
+	/*The ghost frame of the first generation is posted before the loop, then in every generation the cells next to the frame are*/
+	/*computed first and their new values leave at once for the next one, while the inner cells evolve (Generations rules excluded)*/
+	if ((states <= 2) && (evolving > 1)) exchangeHalo(blocks, SideBlocks, frame, neighbours, halotypes, MPI_COMM_WORLD, request);
 
 	/*All generations are sychronized and each output is shown by the master process*/
-	for (i = 0; i < generations; i++)
+	for (i = 0; i < evolving; i++)
 	{
-		if ((my_rank == 0) && (output == 2))
-			show(cells, N);						//Print the cells array as modified in this generation (-o2 in cmd)
+		TRACE_MARK(t);
+		if (output == 2){
+			if (my_rank == 0) show(cells, N);	//Print the cells array as modified in this generation (-o2 in cmd)
+			TRACE_PHASE(TRACE_OUTPUT, i, t);
+		}
+		if (searching && (i % every == 0)){
+			searchBlock(i, blocks, frame, row0 + frame, col0 + frame);		//Occurrences of the patterns in this generation (-p in cmd)
+			TRACE_PHASE(TRACE_OUTPUT, i, t);
+		}
 
 		if (i != generations-1)
 		{
-			/*Send the border 1D (line) arrays to the proper neighbour, who receives this neighbouring line or cell*/
-			neighbour_border = &(blocks[0][0]);
-			MPI_Isend(neighbour_border, 1, MPI_CHAR, upleft, 0, MPI_COMM_WORLD, &request[0]);
-			MPI_Irecv(received_border[0], 1, MPI_CHAR, downright, 0, MPI_COMM_WORLD, &request[1]);			// 0 - downright cell
-			neighbour_border = &(blocks[0][0]);
-			MPI_Isend(neighbour_border, SideBlocks, MPI_CHAR, up, 0, MPI_COMM_WORLD, &request[2]);
-			MPI_Irecv(received_border[1], SideBlocks, MPI_CHAR, down, 0, MPI_COMM_WORLD, &request[3]);		// 1 - down side
-			neighbour_border = &(blocks[0][SideBlocks-1]);
-			MPI_Isend(neighbour_border, 1, MPI_CHAR, upright, 0, MPI_COMM_WORLD, &request[4]);
-			MPI_Irecv(received_border[2], 1, MPI_CHAR, downleft, 0, MPI_COMM_WORLD, &request[5]);			// 2 - downleft cell
-			for (j = 0; j < SideBlocks; j++)
-				side_border[j] = blocks[j][SideBlocks-1];
-			MPI_Isend(side_border, SideBlocks, MPI_CHAR, right, 0, MPI_COMM_WORLD, &request[6]);
-			MPI_Irecv(received_border[3], SideBlocks, MPI_CHAR, left, 0, MPI_COMM_WORLD, &request[7]);		// 3 - left side
-			neighbour_border = &(blocks[SideBlocks-1][SideBlocks-1]);
-			MPI_Isend(neighbour_border, 1, MPI_CHAR, downright, 0, MPI_COMM_WORLD, &request[8]);
-			MPI_Irecv(received_border[4], 1, MPI_CHAR, upleft, 0, MPI_COMM_WORLD, &request[9]);				// 4 - upleft cell
-			neighbour_border = &(blocks[SideBlocks-1][0]);
-			MPI_Isend(neighbour_border, SideBlocks, MPI_CHAR, down, 0, MPI_COMM_WORLD, &request[10]);
-			MPI_Irecv(received_border[5], SideBlocks, MPI_CHAR, up, 0, MPI_COMM_WORLD, &request[11]);		// 5 - up side
-			neighbour_border = &(blocks[SideBlocks-1][0]);
-			MPI_Isend(neighbour_border, 1, MPI_CHAR, downleft, 0, MPI_COMM_WORLD, &request[12]);
-			MPI_Irecv(received_border[6], 1, MPI_CHAR, upright, 0, MPI_COMM_WORLD, &request[13]);			// 6 - upright cell
-			for (j = 0; j < SideBlocks; j++)
-				side_border[j] = blocks[j][0];
-			MPI_Isend(side_border, SideBlocks, MPI_CHAR, left, 0, MPI_COMM_WORLD, &request[14]);
-			MPI_Irecv(received_border[7], SideBlocks, MPI_CHAR, right, 0, MPI_COMM_WORLD, &request[15]);	// 7 - right side
-
 			allzeros = 0;				//Check if there are all 0s (at least one 1, then evolve function returns 1 in allzeros variable)
 			change   = 0;				//Check if the new generation is similar to the previous one (if not change is returned as 1)
+			if (statistics) gol_stats_clear(&blockstats);
+
+			if (states > 2)
+			{
+				/*Generations - the ghost columns come first, then the packed rows (with the corners) travel while the inner rows evolve*/
+				exchangePackedColumns(packed, SideBlocks, bits, left, right, colbuffer, MPI_COMM_WORLD);
+				exchangePackedRows(packed, SideBlocks, bits, up, down, MPI_COMM_WORLD, request);
+				TRACE_PHASE(TRACE_HALO, i, t);
+				if (counting) countersStart();
+				evolve_generations(packed, packed_new, 2, SideBlocks, SideBlocks, bits, gentable, scratch, &allzeros, &change);
+				if (counting) countersStop(kernelcounts[0], innercells);
+				TRACE_PHASE(TRACE_INNER, i, t);
+
+				MPI_Waitall(4, request, status);
+				TRACE_PHASE(TRACE_WAIT, i, t);
+
+				if (counting) countersStart();
+				evolve_generations(packed, packed_new, 1, 2, SideBlocks, bits, gentable, scratch, &allzeros, &change);							//Up line
+				if (SideBlocks > 1)
+					evolve_generations(packed, packed_new, SideBlocks, SideBlocks+1, SideBlocks, bits, gentable, scratch, &allzeros, &change);	//Down line
+				if (counting) countersStop(kernelcounts[1], sidecells);
+				TRACE_PHASE(TRACE_SIDES, i, t);
+			}
+			else if (radius > 0)
+			{
+				/*Larger than Life - the sides (radius cells wide) evolve as soon as the ghost frame is in, and are sent for the next*/
+				/*generation while the cells at least radius away from them evolve*/
+				MPI_Waitall(16, request, status);
+				TRACE_PHASE(TRACE_WAIT, i, t);
+
+				if (counting) countersStart();
+				if (SideBlocks >= 2*radius){
+					evolve_ltl(blocks, new_gen, radius, radius, 2*radius, radius, SideBlocks+radius, ltlrule, colsum, &allzeros, &change, stats);				//Up side
+					evolve_ltl(blocks, new_gen, radius, SideBlocks, SideBlocks+radius, radius, SideBlocks+radius, ltlrule, colsum, &allzeros, &change, stats);	//Down side
+					evolve_ltl(blocks, new_gen, radius, 2*radius, SideBlocks, radius, 2*radius, ltlrule, colsum, &allzeros, &change, stats);					//Left side
+					evolve_ltl(blocks, new_gen, radius, 2*radius, SideBlocks, SideBlocks, SideBlocks+radius, ltlrule, colsum, &allzeros, &change, stats);		//Right side
+				}
+				else evolve_ltl(blocks, new_gen, radius, radius, SideBlocks+radius, radius, SideBlocks+radius, ltlrule, colsum, &allzeros, &change, stats);
+				if (counting) countersStop(kernelcounts[1], sidecells);
+				TRACE_PHASE(TRACE_SIDES, i, t);
 
-			evolve_inner(blocks, new_gen, SideBlocks, &allzeros, &change);		//Until send-receive is done, compute the inner cells
+				if (i+1 != generations-1) exchangeHalo(new_gen, SideBlocks, radius, neighbours, halotypes, MPI_COMM_WORLD, request);
+				TRACE_PHASE(TRACE_HALO, i, t);
 
-			MPI_Waitall(8, request, status);
-			MPI_Barrier(MPI_COMM_WORLD);			//Wait for all processes to send and receive the neighbouring cells
+				if (counting) countersStart();
+				evolve_ltl(blocks, new_gen, radius, 2*radius, SideBlocks, 2*radius, SideBlocks, ltlrule, colsum, &allzeros, &change, stats);
+				if (counting) countersStop(kernelcounts[0], innercells);
+				TRACE_PHASE(TRACE_INNER, i, t);
+			}
+			else
+			{
+				/*B/S rules - the ghost frame (one cell wide) was received straight in the block, the cells next to it evolve first*/
+				MPI_Waitall(16, request, status);
+				TRACE_PHASE(TRACE_WAIT, i, t);
+
+				if (counting) countersStart();
+				/*The cells next to the ghost frame, with the same kernel (no special cases for the sides and the corners)*/
+				gol_evolve_stats(&(blocks[0][0]), &(new_gen[0][0]), SideBlocks+2, 1, 2, 1, SideBlocks+1, rule, &allzeros, &change, stats);						//Up side
+				if (SideBlocks > 1)			//With one row the down side is the up one
+					gol_evolve_stats(&(blocks[0][0]), &(new_gen[0][0]), SideBlocks+2, SideBlocks, SideBlocks+1, 1, SideBlocks+1, rule, &allzeros, &change, stats);	//Down side
+				gol_evolve_stats(&(blocks[0][0]), &(new_gen[0][0]), SideBlocks+2, 2, SideBlocks, 1, 2, rule, &allzeros, &change, stats);							//Left side
+				gol_evolve_stats(&(blocks[0][0]), &(new_gen[0][0]), SideBlocks+2, 2, SideBlocks, SideBlocks, SideBlocks+1, rule, &allzeros, &change, stats);		//Right side
+				if (counting) countersStop(kernelcounts[1], sidecells);
+				TRACE_PHASE(TRACE_SIDES, i, t);
+
+				/*The new sides leave for the next generation (straight in the ghost frame of new_gen) while the inner cells are computed*/
+				if (i+1 != generations-1) exchangeHalo(new_gen, SideBlocks, 1, neighbours, halotypes, MPI_COMM_WORLD, request);
+				TRACE_PHASE(TRACE_HALO, i, t);
+
+				if (counting) countersStart();
+				gol_evolve_stats(&(blocks[0][0]), &(new_gen[0][0]), SideBlocks+2, 2, SideBlocks, 2, SideBlocks, rule, &allzeros, &change, stats);
+				if (counting) countersStop(kernelcounts[0], innercells);
+				TRACE_PHASE(TRACE_INNER, i, t);
+			}
 
-			evolve_sides(blocks, new_gen, received_border, SideBlocks, &allzeros, &change);		//Evolve the side cells of blocks
+			/*The statistics of the blocks are reduced in batches of generations, while the next ones evolve*/
+			if (statistics){
+				statsRecord(i+1, &blockstats, row0, col0);
+				TRACE_PHASE(TRACE_REDUCE, i, t);
+			}
 
 			/*Terminal checking (every 10 generations), if the array is still the same or is full of 0s, then stop the program*/
 			if ((doom == 1) && ((i % 10) == 0) && (i != 0)){
@@ -216,35 +458,70 @@ int main(int argc, char *argv[])
 					fprintf(stderr, "Program terminated (nothing changed or all extinguisted in this generation)\n");
 					MPI_Abort(MPI_COMM_WORLD, 1);
 				}
+				TRACE_PHASE(TRACE_REDUCE, i, t);
 			}
 
-			swap    = blocks;
-			blocks  = new_gen;			//Copy the temporary array to the initial one
-			new_gen = swap;
+			if (states > 2){
+				packed_swap = packed;
+				packed      = packed_new;		//Copy the temporary packed array to the initial one
+				packed_new  = packed_swap;
+			}
+			else {
+				swap    = blocks;
+				blocks  = new_gen;			//Copy the temporary array to the initial one
+				new_gen = swap;
+			}
 
 			/*After each generation, gather all the blocks (with their new values) into the initial cells array (-o2 in cmd)*/
-			if (output == 2)
-				MPI_Gatherv(&(blocks[0][0]), N*N/processes, MPI_CHAR, &(cells[0][0]), counts, starting_point, subarraytype, 0, MPI_COMM_WORLD);
+			if (output == 2){
+				if (states > 2) unpackBlock(packed, blocks, SideBlocks, bits);
+				MPI_Gatherv(&(blocks[0][0]), blockcount, blocktype, &(cells[0][0]), counts, starting_point, subarraytype, 0, MPI_COMM_WORLD);
+				TRACE_PHASE(TRACE_OUTPUT, i, t);
+			}
 		}
 	}
-	/*After all processes are done, gather the blocks with their new values into the initial cells array (Whether there is output or not)*/
-	MPI_Gatherv(&(blocks[0][0]), N*N/processes, MPI_CHAR, &(cells[0][0]), counts, starting_point, subarraytype, 0, MPI_COMM_WORLD);
+	statsFinish();						//Reduce and write the statistics of the last generations
+	searchFinish();						//Close the file of the patterns and print how many were found
 
+	/*After all processes are done, gather the blocks with their new values into the initial cells array (Whether there is output or not)*/
+	if (states > 2) unpackBlock(packed, blocks, SideBlocks, bits);
+
+	/*The connected clusters of live cells of the last generation, labelled where the blocks are, without gathering them (-C in cmd)*/
+	if (clusterfile != NULL){
+		clusters = clustersWrite(clusterfile, blocks, SideBlocks, frame, (thread_count > 0) ? thread_count : 1, my_rank, SideProcesses, neighbours, MPI_COMM_WORLD);
+		if (clusters < 0){
+			if (my_rank == 0) fprintf(stderr, "Cannot write the clusters in %s\n", clusterfile);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+	}
+	TRACE_MARK(t);
+	MPI_Gatherv(&(blocks[0][0]), blockcount, blocktype, &(cells[0][0]), counts, starting_point, subarraytype, 0, MPI_COMM_WORLD);
+	TRACE_PHASE(TRACE_OUTPUT, generations-1, t);
 
-	for (i = 0; i < 8; i++)
-		free(help2[i]);					//Delete received_border 2D array (for receiving side cells depending on topology)
-	free(help2);
-	free(help1);						//Delete neighbour_border array (for copying side cells)
 
 	if (my_rank == 0){
 		if (output == 1)
 			show(cells, N);				//If told from command line, print the array (-o1 in cmd)
+		if (dumpfile != NULL)
+			dump(cells, N, (generations > 0) ? generations-1 : 0, dumpfile);		//Write the final cells in a file (-w in cmd)
 		deleteArray(&cells);			//Delete cells array
 	}
 	deleteArray(&blocks);				//Delete blocks array on each process
 	deleteArray(&new_gen);				//Delete the temporary array for copying new values
 
 	MPI_Type_free(&subarraytype);		//Free the subarray type
+	if (frame > 0){
+		MPI_Type_free(&blocktype);		//Free the block interior and ghost frame types
+		freeHaloTypes(halotypes);
+	}
+	free(colsum);
+	free(ltlrule);
+	if (states > 2){
+		deletePacked(&packed);			//Delete the packed blocks of a Generations rule
+		deletePacked(&packed_new);
+		free(colbuffer);
+		free(scratch);
+	}
 
 
 	/*Stop timer and calculate the whole time of mpi procedures (generally the program time)*/
@@ -256,6 +533,11 @@ int main(int argc, char *argv[])
 	MPI_Reduce(&alltime, &maxtime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
 	MPI_Reduce(&alltime, &mintime, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
 	MPI_Reduce(&alltime, &sumtime, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+	if (counting){
+		MPI_Reduce(kernelcounts, allcounts, 2*(COUNTERS+1), MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+		MPI_Reduce(&available, &allavailable, 1, MPI_INT, MPI_BAND, 0, MPI_COMM_WORLD);		//Only the counters that all processes have
+		countersClose();
+	}
 	if (my_rank == 0){
 		printf("\n///////////////////////////////////////////////////\n\n");
 		printf("--------------------------------------------------------------\n");
@@ -263,8 +545,12 @@ int main(int argc, char *argv[])
 		printf("Minimum Runtime = %f\n", mintime);
 		printf("Average Runtime = %f\n", sumtime/processes);
 		printf("--------------------------------------------------------------\n");
+		if (clusterfile != NULL) printf("Clusters = %ld\n", clusters);
+		if (counting) countersShow(allcounts, kernels, 2, allavailable);
 	}
+	traceFinish(MPI_COMM_WORLD, my_rank, processes);		//Write the trace and the time of each phase (-T in cmd)
 
+	emptyPool();						//Return the buffers of the pool to the system
 	MPI_Finalize();						//End the MPI procedure
 
 	return 0;
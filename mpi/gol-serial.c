@@ -2,18 +2,26 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include "gol.h"
+#include "ltl.h"
+#include "generations.h"
+#include "unbounded.h"
+#include "counters.h"
+#include "memory.h"
+#include "loader.h"
 
 
 
-/*Allocate memory for a 2D array and initialize it*/
+/*Allocate memory for a 2D array with contiguous memory and initialize it*/
 char **allocateArray(int n, int init_flag)
 {
-	char **array;
+	char *p, **array;
 	int  i, j;
 
+	p = allocateCells((size_t)n*n*sizeof(char));		//Aligned, from the pool, huge pages if large
 	array = malloc(n * sizeof(char*));
 	for (i = 0; i < n; i++){
-		array[i] = malloc(n * sizeof(char));
+		array[i] = &(p[i*n]);
 		for (j = 0; j < n; j++){
 			if (init_flag == 0) array[i][j] = 0;			//Initialize the array items as 0s
 			else array[i][j] = rand() % 2;
@@ -24,26 +32,25 @@ char **allocateArray(int n, int init_flag)
 
 
 
-/*Delete a 2D array which has dynamically allocated*/
-void deleteArray(char **array, int n)
+/*Delete a 2D array created in the way above*/
+void deleteArray(char **array)
 {
-	int i;
-	for (i = 0; i < n; i++)
-		free(array[i]);
+	releaseCells(array[0]);
 	free(array);
 }
 
 
 
-/*Print the cells in command line*/
-void show(char **cells, int N)
+/*Print the cells in command line (the N x N cells start at [offset][offset], after a ghost frame if there is one)*/
+void show(char **cells, int N, int offset)
 {
 	int i, j;
 	printf("\n///////////////////////////////////////////////////\n\n");
-	for (i = 0; i < N; i++){
-		for (j = 0; j < N; j++){
+	for (i = offset; i < N+offset; i++){
+		for (j = offset; j < N+offset; j++){
 			if (cells[i][j] == 0) printf("-");
 			else if (cells[i][j] == 1) printf("X");
+			else if (cells[i][j] < 16) printf("%X", cells[i][j]);		//Dying cells of a Generations rule
 			else printf("?");
 		}
 		printf("\n");
@@ -52,29 +59,22 @@ void show(char **cells, int N)
 
 
 
-/*The cells evolve - move to next generation*/
-void evolve(char **old_gen, char **new_gen, int N)
+/*Write the cells in a file that other programs read (e.g. gol-verify): the side and the generations computed in the first line,*/
+/*then "row column state" for every cell that is not dead, row by row*/
+void dump(char **cells, int N, int offset, int generations, const char *filename)
 {
-	int i, j, ul, u, ur, l, r, dl, d, dr, neighbors;
+	int  i, j;
+	FILE *fp = fopen(filename, "w");
 
+	if (fp == NULL){
+		fprintf(stderr, "Cannot write the cells in %s\n", filename);
+		return;
+	}
+	fprintf(fp, "%d %d\n", N, generations);
 	for (i = 0; i < N; i++)
-	{
 		for (j = 0; j < N; j++)
-		{
-			ul = old_gen[((i-1)+N)%N][((j-1)+N)%N]; 
-			u  = old_gen[((i-1)+N)%N][((j)+N)%N];
-			ur = old_gen[((i-1)+N)%N][((j+1)+N)%N];
-			l  = old_gen[((i)+N)%N][((j-1)+N)%N];
-			r  = old_gen[((i)+N)%N][((j+1)+N)%N];
-			dl = old_gen[((i+1)+N)%N][((j-1)+N)%N];
-			d  = old_gen[((i+1)+N)%N][((j)+N)%N];
-			dr = old_gen[((i+1)+N)%N][((j+1)+N)%N];
-			neighbors = u + ur + ul + l + r + dr + dl + d;
-
-			char cell     = old_gen[i][j];
-			new_gen[i][j] = neighbors == 3 || (neighbors == 2 && cell);
-		}
-	}
+			if (cells[i+offset][j+offset] != 0) fprintf(fp, "%d %d %d\n", i, j, cells[i+offset][j+offset]);
+	fclose(fp);
 }
 
 
@@ -82,61 +82,188 @@ void evolve(char **old_gen, char **new_gen, int N)
 /*Main program*/
 int main(int argc, char const *argv[])
 {
-	int  i, j, q, N, generations;
+	int  i, j, q, N, generations, unbounded = 0, radius = 0, frame, allzeros, change, *colsum = NULL, states = 2, bits = 0;
 	char output = 0;
-	char **cells, **new_gen, **swap;
-	char line[64], *token, delim[2] = " ";
-	FILE *fp = NULL;
+	char **cells, **new_gen, **swap, rule[2][9], *rulestring = "B3/S23", *dumpfile = NULL, *ltlrule = NULL, gentable[GEN_MAX_STATES][9], *scratch = NULL;
+	unsigned char **packed = NULL, **packed_new = NULL, **packed_swap;
+	char *inputfile = NULL;
+	mapped input;
+	universe *u = NULL;
+	int  counting = 0, available = 0;
+	long long counts[2][COUNTERS+1] = {{0}};
+	const char *kernels[2] = {"gol_evolve", "fillGhosts"};
 
 	/*Read the arguments*/
 	for (i = 0; i < argc; i++){
 		if (!strcmp(argv[i], "-n")) N = atoi(argv[++i]);
 		else if (!strcmp(argv[i], "-g")) generations = atoi(argv[++i]);
-		else if (!strcmp(argv[i], "-i")) fp = fopen(argv[++i], "r");
+		else if (!strcmp(argv[i], "-i")) inputfile = (char *)argv[++i];
 		else if (!strcmp(argv[i], "-o1")) output = 1;
 		else if (!strcmp(argv[i], "-o2")) output = 2;
+		else if (!strcmp(argv[i], "-r")) rulestring = (char *)argv[++i];
+		else if (!strcmp(argv[i], "-u")) unbounded = 1;
+		else if (!strcmp(argv[i], "-c")) counting = 1;
+		else if (!strcmp(argv[i], "-w")) dumpfile = (char *)argv[++i];
+	}
+
+	/*Build the transition table of the rule (Conway's B3/S23 by default, or Larger than Life if it starts with the range R), or else exit*/
+	if (rulestring[0] == 'R'){
+		ltlrule = parseLtLRule(rulestring, &radius);
+		if ((ltlrule == NULL) || (radius > N)){
+			fprintf(stderr, "Invalid rule %s (e.g. R5,C0,M1,S34..58,B34..45,NM with range up to %d)\n", rulestring, LTL_MAX_RADIUS);
+			return 1;
+		}
+		colsum = malloc((N+2*radius) * sizeof(int));
+	}
+	else if ((strchr(rulestring, 'C') != NULL) || (strchr(rulestring, 'c') != NULL)){
+		if (parseGenRule(rulestring, gentable, &states) != 0){
+			fprintf(stderr, "Invalid rule %s (e.g. B2/S/C3 with up to %d states)\n", rulestring, GEN_MAX_STATES);
+			return 1;
+		}
+		if (states == 2) memcpy(rule, gentable, sizeof(rule));		//Two states (/C2) is a plain B/S rule
+		bits = packedBits(states);			//Generations rules keep their cells packed (2 or 4 bits each), with a ghost frame one cell wide
+		packed     = allocatePacked(N+2, packedBytes(N+2, bits));
+		packed_new = allocatePacked(N+2, packedBytes(N+2, bits));
+		scratch    = malloc(5*(N+2) * sizeof(char));
+	}
+	else if (gol_parse_rule(rulestring, rule) != 0){
+		fprintf(stderr, "Invalid rule %s (B/S notation is expected, e.g. B36/S23)\n", rulestring);
+		return 1;
+	}
+
+	/*Map the input file in memory (if there is one), its lines are scanned straight from the mapping*/
+	if ((inputfile != NULL) && (mapInput(inputfile, &input) != 0)){
+		fprintf(stderr, "Cannot read the input file %s\n", inputfile);
+		return 1;
+	}
+
+	/*The unbounded plane (-u) takes only B/S rules without B0, it is not a torus of N x N cells (N is only the side of a random start)*/
+	if (unbounded){
+		if ((radius > 0) || (states > 2) || (checkUnboundedRule(rule) != 0)){
+			fprintf(stderr, "Invalid rule %s for an unbounded plane (B/S notation without B0 is expected)\n", rulestring);
+			return 1;
+		}
+		u = createUniverse();
+		if (inputfile == NULL){
+			srand(time(NULL));
+			for (i = 0; i < N; i++)
+				for (j = 0; j < N; j++)
+					if (rand() % 2) setCellUnbounded(u, i, j);
+		}
+		else {
+			while (nextCoordinates(&input, &i, &j))
+				setCellUnbounded(u, i, j);
+			unmapInput(&input);
+		}
+
+		kernels[0] = "evolveUnbounded";
+		if (counting) available = countersOpen();		//Hardware counters around the kernel (-c)
+		clock_t start = clock();						//Begin counting time
+
+		for (q = 0; q < generations; q++)
+		{
+			if (output == 2) showUnbounded(u);			//Print the live cells in every generation if told so in command line (-o2)
+			if (q != generations-1){
+				if (counting) countersStart();
+				evolveUnbounded(u, rule, &allzeros, &change);
+				if (counting) countersStop(counts[0], (long long)u->count * CHUNK_SIZE * CHUNK_SIZE);
+			}
+		}
+		if (output == 1) showUnbounded(u);				//Print the live cells only at the end (-o1)
+		deleteUniverse(&u);
+
+		/*Finish counting time, print it*/
+		clock_t finish = clock();
+		double alltime = (double)(finish - start) / CLOCKS_PER_SEC;
+		printf("\n///////////////////////////////////////////////////\n\n");
+		printf("--------------------------------------------------------------\n");
+		printf("Runtime %f \n", alltime);
+		printf("--------------------------------------------------------------\n");
+		if (counting){
+			countersShow(counts, kernels, 1, available);
+			countersClose();
+		}
+		return 0;
 	}
 
 	/*Allocate memory for cells and new_gen arrays and initialize them with 0s or randomly*/
-	if (fp == NULL){
+	/*They keep a ghost frame (radius cells wide for Larger than Life, one cell for B/S rules), filled with the opposite sides in every*/
+	/*generation, so that the kernel of libgol needs no modulos (Generations rules keep their own packed arrays)*/
+	frame = (radius > 0) ? radius : ((states > 2) ? 0 : 1);
+	if (inputfile == NULL){
 		srand(time(NULL));
-		cells = allocateArray(N, 1);
+		cells = allocateArray(N+2*frame, 1);
 	}
-	else cells = allocateArray(N, 0);
-	new_gen = allocateArray(N, 0);
+	else cells = allocateArray(N+2*frame, 0);
+	new_gen = allocateArray(N+2*frame, 0);
 
 	/*Read from input file the position of initial live cells (if there is input file)*/
-	if (fp != NULL){
-		fgets(line, 64, fp);
-		while (!feof(fp)){
-			token = strtok(line, delim);
-			i = atoi(token);
-			token = strtok(NULL, delim);
-			j = atoi(token);
-			cells[i][j] = 1;
-			fgets(line, 64, fp);
+	if (inputfile != NULL){
+		while (nextCoordinates(&input, &i, &j)){
+			if ((i < 0) || (j < 0) || (i >= N) || (j >= N)){
+				fprintf(stderr, "The cell %d %d of %s is out of the %d x %d board\n", i, j, inputfile, N, N);
+				return 1;
+			}
+			cells[i+frame][j+frame] = 1;
 		}
-		fclose(fp);
+		unmapInput(&input);
 	}
 
+	if (states > 2) packBlock(cells, packed, N, bits);
+
+	/*Hardware counters around the kernel and the filling of the ghost frame (-c)*/
+	if (states > 2) kernels[0] = "evolve_generations";
+	else if (radius > 0) kernels[0] = "evolve_ltl";
+	if (counting) available = countersOpen();
+
 	clock_t start = clock();							//Begin counting time
 
 	/*Calculate every generation and print it*/
 	for (q = 0; q < generations; q++)
 	{
-		if (output == 2) show(cells, N);		//Print the cells array in every generation if told so in command line (-o2)
+		if ((output == 2) && (states > 2)) unpackBlock(packed, cells, N, bits);
+		if (output == 2) show(cells, N, frame);		//Print the cells array in every generation if told so in command line (-o2)
 
 		if (q != generations-1){
-			evolve(cells, new_gen, N);
-			swap    = cells;
-			cells   = new_gen;
-			new_gen = swap;
+			if (counting) countersStart();
+			if (states > 2) fillPackedGhosts(packed, N, bits);
+			else fillGhosts(cells, N, frame);
+			if (counting){
+				countersStop(counts[1], (long long)N*N);
+				countersStart();
+			}
+
+			if (states > 2) evolve_generations(packed, packed_new, 1, N+1, N, bits, gentable, scratch, &allzeros, &change);
+			else if (radius > 0) evolve_ltl(cells, new_gen, radius, radius, N+radius, radius, N+radius, ltlrule, colsum, &allzeros, &change, NULL);
+			else gol_evolve(&(cells[0][0]), &(new_gen[0][0]), N+2, 1, N+1, 1, N+1, rule, &allzeros, &change);
+			if (counting) countersStop(counts[0], (long long)N*N);
+
+			if (states > 2){
+				packed_swap = packed;
+				packed      = packed_new;
+				packed_new  = packed_swap;
+			}
+			else {
+				swap    = cells;
+				cells   = new_gen;
+				new_gen = swap;
+			}
 		}
 	}
-	if (output == 1) show(cells, N);			//Print the cells array only at the end (-o1)
+	if (states > 2) unpackBlock(packed, cells, N, bits);
+	if (output == 1) show(cells, N, frame);			//Print the cells array only at the end (-o1)
+	if (dumpfile != NULL) dump(cells, N, frame, (generations > 0) ? generations-1 : 0, dumpfile);		//Write them in a file (-w)
 
-	deleteArray(cells, N);
-	deleteArray(new_gen, N);
+	deleteArray(cells);
+	deleteArray(new_gen);
+	free(colsum);
+	free(ltlrule);
+	if (packed != NULL){
+		deletePacked(&packed);
+		deletePacked(&packed_new);
+		free(scratch);
+	}
+	emptyPool();					//Return the buffers of the pool to the system
 
 	/*Finish counting time, print it*/
 	clock_t finish = clock();
@@ -145,6 +272,10 @@ int main(int argc, char const *argv[])
 	printf("--------------------------------------------------------------\n");
 	printf("Runtime %f \n", alltime);
 	printf("--------------------------------------------------------------\n");
+	if (counting){
+		countersShow(counts, kernels, 2, available);
+		countersClose();
+	}
 
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "halo.h"
+#include "generations.h"
+
+
+
+/*Create the datatypes of a halo r cells wide around the n x n interior of a padded (n+2r)x(n+2r) block*/
+/*0 - up/down side (r rows of n cells), 1 - left/right side (n rows of r cells), 2 - corner (r rows of r cells)*/
+void createHaloTypes(int n, int r, MPI_Datatype types[3])
+{
+	MPI_Type_vector(r, n, n+2*r, MPI_CHAR, &types[0]);
+	MPI_Type_vector(n, r, n+2*r, MPI_CHAR, &types[1]);
+	MPI_Type_vector(r, r, n+2*r, MPI_CHAR, &types[2]);
+	MPI_Type_commit(&types[0]);
+	MPI_Type_commit(&types[1]);
+	MPI_Type_commit(&types[2]);
+}
+
+
+
+/*Free the halo datatypes*/
+void freeHaloTypes(MPI_Datatype types[3])
+{
+	MPI_Type_free(&types[0]);
+	MPI_Type_free(&types[1]);
+	MPI_Type_free(&types[2]);
+}
+
+
+
+/*Post the non-blocking sends of the block's borders and the receives of the ghost frame (the caller waits for the 16 requests)*/
+/*The neighbours are given clockwise: upleft, up, upright, right, downright, down, downleft, left*/
+void exchangeHalo(char **pad, int n, int r, int neighbours[8], MPI_Datatype types[3], MPI_Comm comm, MPI_Request request[16])
+{
+	int d;
+	int  row[8]  = {r, r, r, r, n, n, n, r};						//Where each border to send starts (interior cells)
+	int  col[8]  = {r, r, n, n, n, r, r, r};
+	int  grow[8] = {n+r, n+r, n+r, r, 0, 0, 0, r};					//Where the ghost part received from the opposite neighbour starts
+	int  gcol[8] = {n+r, r, 0, 0, 0, r, n+r, n+r};
+	int  type[8] = {2, 0, 2, 1, 2, 0, 2, 1};
+
+	for (d = 0; d < 8; d++){
+		/*Send the border towards neighbour d and receive the same border of the opposite neighbour (tag d keeps the pairs apart)*/
+		MPI_Isend(&pad[row[d]][col[d]], 1, types[type[d]], neighbours[d], d, comm, &request[2*d]);
+		MPI_Irecv(&pad[grow[d]][gcol[d]], 1, types[type[d]], neighbours[(d+4)%8], d, comm, &request[2*d+1]);
+	}
+}
+
+
+
+/*First phase of the halo of a packed block (Generations rules) - the ghost columns, packed in buffer (4 packed columns of n cells)*/
+void exchangePackedColumns(unsigned char **pad, int n, int bits, int left, int right, unsigned char *buffer, MPI_Comm comm)
+{
+	int i, bytes = packedBytes(n, bits);
+	MPI_Request request[4];
+	MPI_Status  status[4];
+
+	memset(buffer, 0, 2*bytes);
+	for (i = 0; i < n; i++){
+		setCell(&buffer[0], i, bits, getCell(pad[i+1], 1, bits));			//Left side of the block
+		setCell(&buffer[bytes], i, bits, getCell(pad[i+1], n, bits));		//Right side of the block
+	}
+	MPI_Isend(&buffer[0], bytes, MPI_UNSIGNED_CHAR, left, 0, comm, &request[0]);
+	MPI_Irecv(&buffer[2*bytes], bytes, MPI_UNSIGNED_CHAR, right, 0, comm, &request[1]);
+	MPI_Isend(&buffer[bytes], bytes, MPI_UNSIGNED_CHAR, right, 1, comm, &request[2]);
+	MPI_Irecv(&buffer[3*bytes], bytes, MPI_UNSIGNED_CHAR, left, 1, comm, &request[3]);
+	MPI_Waitall(4, request, status);
+
+	for (i = 0; i < n; i++){
+		setCell(pad[i+1], n+1, bits, getCell(&buffer[2*bytes], i, bits));	//Right ghost column
+		setCell(pad[i+1], 0, bits, getCell(&buffer[3*bytes], i, bits));		//Left ghost column
+	}
+}
+
+
+
+/*Second phase of the halo of a packed block - post the whole packed up and down rows, which carry the corners along (the caller waits)*/
+void exchangePackedRows(unsigned char **pad, int n, int bits, int up, int down, MPI_Comm comm, MPI_Request request[4])
+{
+	int bytes = packedBytes(n+2, bits);
+
+	MPI_Isend(pad[1], bytes, MPI_UNSIGNED_CHAR, up, 2, comm, &request[0]);
+	MPI_Irecv(pad[n+1], bytes, MPI_UNSIGNED_CHAR, down, 2, comm, &request[1]);
+	MPI_Isend(pad[n], bytes, MPI_UNSIGNED_CHAR, down, 3, comm, &request[2]);
+	MPI_Irecv(pad[0], bytes, MPI_UNSIGNED_CHAR, up, 3, comm, &request[3]);
+}
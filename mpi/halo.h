@@ -0,0 +1,14 @@
+#ifndef __halo__
+#define __halo__
+
+#include "mpi.h"
+
+
+void createHaloTypes(int n, int r, MPI_Datatype types[3]);
+void freeHaloTypes(MPI_Datatype types[3]);
+void exchangeHalo(char **pad, int n, int r, int neighbours[8], MPI_Datatype types[3], MPI_Comm comm, MPI_Request request[16]);
+void exchangePackedColumns(unsigned char **pad, int n, int bits, int left, int right, unsigned char *buffer, MPI_Comm comm);
+void exchangePackedRows(unsigned char **pad, int n, int bits, int up, int down, MPI_Comm comm, MPI_Request request[4]);
+
+
+#endif
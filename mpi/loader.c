@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "loader.h"
+
+
+
+/*Map a whole input file in memory (read only, the pages come straight from the page cache without any copy), returns -1 if it*/
+/*cannot be opened or mapped. An empty file is mapped as no text at all*/
+int mapInput(const char *filename, mapped *input)
+{
+	int  fd;
+	struct stat st;
+
+	input->text   = NULL;
+	input->length = input->next = input->stop = 0;
+	fd = open(filename, O_RDONLY);
+	if (fd < 0) return -1;
+	if (fstat(fd, &st) != 0){
+		close(fd);
+		return -1;
+	}
+	if (st.st_size > 0){
+		input->text = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (input->text == MAP_FAILED){
+			input->text = NULL;
+			close(fd);
+			return -1;
+		}
+		madvise(input->text, st.st_size, MADV_SEQUENTIAL);			//Read ahead, it is scanned from the start to the end
+	}
+	close(fd);													//The mapping stays without the descriptor
+	input->length = st.st_size;
+	input->stop   = st.st_size;
+	return 0;
+}
+
+
+
+void unmapInput(mapped *input)
+{
+	if (input->text != NULL) munmap(input->text, input->length);
+	input->text   = NULL;
+	input->length = input->next = input->stop = 0;
+}
+
+
+
+/*The first byte of the line after the one that has byte at*/
+static size_t lineAfter(const mapped *input, size_t at)
+{
+	const char *eol;
+
+	if (at == 0) return 0;
+	eol = memchr(input->text + at-1, '\n', input->length - (at-1));
+	return (eol == NULL) ? input->length : (size_t)(eol - input->text) + 1;
+}
+
+
+
+/*Keep only part (0..parts-1) of the lines of the file to scan, every process or thread takes one and all of them cover each line once*/
+void splitInput(mapped *input, int part, int parts)
+{
+	input->next = lineAfter(input, input->length / parts * part);
+	input->stop = (part == parts-1) ? input->length : lineAfter(input, input->length / parts * (part+1));
+}
+
+
+
+/*Read a number without sign at *p (before end), after spaces or tabs, returns 0 if there is none or it does not fit in an int*/
+static int readNumber(const char **p, const char *end, int *value)
+{
+	const char *q = *p;
+	int  v = 0;
+
+	while ((q < end) && ((*q == ' ') || (*q == '\t'))) q++;
+	if ((q == end) || ((unsigned)(*q - '0') > 9)) return 0;
+	while ((q < end) && ((unsigned)(*q - '0') <= 9)){
+		if (v > (INT_MAX - (*q - '0')) / 10) return 0;
+		v = 10*v + (*q - '0');
+		q++;
+	}
+	*value = v;
+	*p     = q;
+	return 1;
+}
+
+
+
+/*The next line "row column" of a coordinates file (anything else after them in the line is ignored, lines without two numbers, or*/
+/*with a number beyond INT_MAX, are skipped), returns 0 at the end of the part to scan. memchr() finds the end of every line (with*/
+/*vector instructions in glibc)*/
+int nextCoordinates(mapped *input, int *i, int *j)
+{
+	const char *p, *eol, *stop = input->text + input->stop;
+
+	while (input->next < input->stop){
+		p   = input->text + input->next;
+		eol = memchr(p, '\n', stop - p);
+		if (eol == NULL) eol = stop;
+		input->next = (eol - input->text) + 1;
+		if (readNumber(&p, eol, i) && readNumber(&p, eol, j)) return 1;
+	}
+	return 0;
+}
+
+
+
+/*Copy a rows x cols block, starting at cell (row0, col0), of an N x N grid file ("0 1 0 ...", every cell is a digit and a space or*/
+/*a new line) in block[offset..][offset..]. Every cell is at a known place, so the block is read without any scanning (returns -1*/
+/*if the file is not 2*N*N bytes)*/
+int readGrid(const mapped *input, int N, int row0, int col0, int rows, int cols, char **block, int offset)
+{
+	int  i, j;
+	const char *p;
+	char *out;
+
+	if (input->length != (size_t)2*N*N) return -1;
+	for (i = 0; i < rows; i++){
+		p   = input->text + (size_t)2*N*(row0+i) + 2*col0;
+		out = block[i+offset] + offset;
+		for (j = 0; j < cols; j++)
+			out[j] = p[2*j] - '0';
+	}
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ltl.h"
+
+
+
+/*Build the transition table of a Larger than Life rule given in the form R5,C0,M1,S34..58,B34..45,NM*/
+/*The table is indexed as rule[cell*(K+1) + sum], where K = (2r+1)^2 and sum counts the live cells of the whole (2r+1)x(2r+1) box*/
+char *parseLtLRule(const char *rulestring, int *radius)
+{
+	int  r = 0, middle = 0, states = 2, smin = 1, smax = 0, bmin = 1, bmax = 0;
+	int  K, sum, neighbours, lo, hi;
+	char *rule, *copy, *token;
+
+	copy = strdup(rulestring);
+	for (token = strtok(copy, ","); token != NULL; token = strtok(NULL, ",")){
+		if (token[0] == 'R') r = atoi(token+1);								//Range of the neighbourhood
+		else if (token[0] == 'C') states = atoi(token+1);					//Only 2 states (C0 or C2) are supported
+		else if (token[0] == 'M') middle = atoi(token+1);					//Does the cell count itself as a neighbour
+		else if (((token[0] == 'S') || (token[0] == 'B')) && (sscanf(token+1, "%d..%d", &lo, &hi) == 2)){
+			if (token[0] == 'S'){ smin = lo; smax = hi; }					//Survival range
+			else { bmin = lo; bmax = hi; }									//Birth range
+		}
+		else if (strcmp(token, "NM") != 0){									//Only the Moore neighbourhood is supported
+			free(copy);
+			return NULL;
+		}
+	}
+	free(copy);
+	if ((r < 1) || (r > LTL_MAX_RADIUS) || ((states != 0) && (states != 2)) || ((middle != 0) && (middle != 1)))
+		return NULL;
+
+	K = (2*r+1)*(2*r+1);
+	rule = malloc(2*(K+1) * sizeof(char));
+	for (sum = 0; sum <= K; sum++){
+		rule[sum] = (sum >= bmin) && (sum <= bmax);							//A dead cell never counts itself
+		neighbours = middle ? sum : sum-1;									//A live cell counts itself only with M1
+		rule[(K+1)+sum] = (sum >= 1) && (neighbours >= smin) && (neighbours <= smax);
+	}
+	*radius = r;
+	return rule;
+}
+
+
+
+/*Copy the opposite sides of a padded (n+2r)x(n+2r) array in its ghost frame, so that the n x n interior wraps around*/
+void fillGhosts(char **pad, int n, int r)
+{
+	int i;
+
+	for (i = r; i < n+r; i++){
+		memcpy(&pad[i][0], &pad[i][n], r*sizeof(char));				//Left ghost columns from the right side
+		memcpy(&pad[i][n+r], &pad[i][r], r*sizeof(char));			//Right ghost columns from the left side
+	}
+	for (i = 0; i < r; i++){
+		memcpy(pad[i], pad[n+i], (n+2*r)*sizeof(char));				//Up ghost rows (with the corners) from the down side
+		memcpy(pad[n+r+i], pad[r+i], (n+2*r)*sizeof(char));			//Down ghost rows (with the corners) from the up side
+	}
+}
+
+
+
+/*Add the counts of row i (computed by the kernel) to the statistics and grow their bounding box with its live cells*/
+static void addRow(gol_stats *stats, const char *row, int i, int col0, int col1, int population, int births, int deaths)
+{
+	int j;
+
+	stats->population += population;
+	stats->births     += births;
+	stats->deaths     += deaths;
+	if (population == 0) return;
+	if (i < stats->top) stats->top = i;
+	if (i > stats->bottom) stats->bottom = i;
+	for (j = col0; (j < col1) && (j < stats->left); j++)
+		if (row[j]){
+			stats->left = j;
+			break;
+		}
+	for (j = col1-1; (j >= col0) && (j > stats->right); j--)
+		if (row[j]){
+			stats->right = j;
+			break;
+		}
+}
+
+
+
+/*The cells [row0,row1)x[col0,col1) of a padded array evolve under a Larger than Life rule (with the statistics, if stats is not NULL)*/
+/*Column sums of the (2r+1) rows around each row roll downwards and a window slides along them, so every cell costs O(1) instead of O(r^2)*/
+void evolve_ltl(char **old_gen, char **new_gen, int r, int row0, int row1, int col0, int col1, char *rule, int *colsum, int *allzeros, int *change, gol_stats *stats)
+{
+	int i, j, k, sum, K1 = (2*r+1)*(2*r+1)+1, population, births, deaths;
+
+	if ((row0 >= row1) || (col0 >= col1)) return;
+
+	/*The column sums of the first row (colsum[j-col0+r] holds the column j)*/
+	for (j = col0-r; j < col1+r; j++){
+		colsum[j-col0+r] = 0;
+		for (k = row0-r; k <= row0+r; k++)
+			colsum[j-col0+r] += old_gen[k][j];
+	}
+
+	for (i = row0; i < row1; i++)
+	{
+		if (i != row0){								//Roll the column sums one row down
+			for (j = col0-r; j < col1+r; j++)
+				colsum[j-col0+r] += old_gen[i+r][j] - old_gen[i-r-1][j];
+		}
+
+		sum = 0;
+		for (k = 0; k < 2*r+1; k++)					//The box of the first cell of the row
+			sum += colsum[k];
+		population = births = deaths = 0;
+
+		for (j = col0; j < col1; j++)
+		{
+			if (j != col0)							//Slide the box one column right
+				sum += colsum[j-col0+2*r] - colsum[j-col0-1];
+
+			new_gen[i][j] = rule[old_gen[i][j]*K1 + sum];		//Assign new values from the rule's transition table
+
+			if (new_gen[i][j] != 0) *allzeros = 1;
+			if (new_gen[i][j] != old_gen[i][j]) *change = 1;
+			population += new_gen[i][j];
+			births     += new_gen[i][j] & ~old_gen[i][j];
+			deaths     += old_gen[i][j] & ~new_gen[i][j];
+		}
+		if (stats != NULL) addRow(stats, new_gen[i], i, col0, col1, population, births, deaths);
+	}
+}
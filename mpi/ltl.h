@@ -0,0 +1,15 @@
+#ifndef __ltl__
+#define __ltl__
+
+#include "gol.h"
+
+
+#define LTL_MAX_RADIUS 10
+
+
+char *parseLtLRule(const char *rulestring, int *radius);
+void fillGhosts(char **pad, int n, int r);
+void evolve_ltl(char **old_gen, char **new_gen, int r, int row0, int row1, int col0, int col1, char *rule, int *colsum, int *allzeros, int *change, gol_stats *stats);
+
+
+#endif
@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include "memory.h"
+
+
+/*Every buffer given by allocateCells() stays in the pool, when it is released it waits there for the next request of the same size*/
+/*(e.g. the arrays of the next board of a batch, or of the next run in the same process), so it is not unmapped and faulted in again*/
+typedef struct {
+	void   *p;
+	size_t bytes;				//Size rounded up (to CELL_ALIGN, or to HUGE_PAGE for the large ones)
+	char   mapped;				//1 if it was mapped with mmap(), 0 if posix_memalign() gave it
+	char   used;				//0 if it was released and waits in the pool
+} buffer;
+
+static buffer *pool = NULL;
+static int    pooled = 0, capacity = 0;
+
+
+
+static size_t roundUp(size_t bytes, size_t unit)
+{
+	return (bytes + unit-1) / unit * unit;
+}
+
+
+
+/*Map a large buffer aligned to a huge page: from the reserved huge pages (vm.nr_hugepages) if there are enough, or else with*/
+/*transparent huge pages, mapping one page more and cutting the parts before and after the aligned address*/
+static void *mapHuge(size_t bytes)
+{
+	char   *p = MAP_FAILED, *aligned;
+	size_t head;
+
+#ifdef MAP_HUGETLB
+	p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+	if (p != MAP_FAILED) return p;
+#endif
+	p = mmap(NULL, bytes + HUGE_PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (p == MAP_FAILED) return NULL;
+	aligned = (char *)roundUp((size_t)p, HUGE_PAGE);
+	head    = aligned - p;
+	if (head > 0) munmap(p, head);
+	munmap(aligned + bytes, HUGE_PAGE - head);
+#ifdef MADV_HUGEPAGE
+	madvise(aligned, bytes, MADV_HUGEPAGE);
+#endif
+	return aligned;
+}
+
+
+
+/*A buffer of at least bytes, aligned to CELL_ALIGN and backed by huge pages if it is large (returns NULL if there is no memory).*/
+/*Its contents are not initialized, since a buffer from the pool keeps the cells of its last use*/
+void *allocateCells(size_t bytes)
+{
+	int  k;
+	void *p = NULL;
+	char mapped = (bytes >= HUGE_THRESHOLD);
+
+	bytes = mapped ? roundUp(bytes, HUGE_PAGE) : roundUp((bytes > 0) ? bytes : 1, CELL_ALIGN);
+	for (k = 0; k < pooled; k++){
+		if (!pool[k].used && (pool[k].bytes == bytes)){
+			pool[k].used = 1;
+			return pool[k].p;
+		}
+	}
+
+	if (mapped) p = mapHuge(bytes);
+	else if (posix_memalign(&p, CELL_ALIGN, bytes) != 0) p = NULL;
+	if (p == NULL) return NULL;
+
+	if (pooled == capacity){
+		capacity = (capacity > 0) ? 2*capacity : 16;
+		pool = realloc(pool, capacity * sizeof(buffer));
+	}
+	pool[pooled].p      = p;
+	pool[pooled].bytes  = bytes;
+	pool[pooled].mapped = mapped;
+	pool[pooled].used   = 1;
+	pooled++;
+	return p;
+}
+
+
+
+/*Give a buffer back to the pool (NULL is ignored)*/
+void releaseCells(void *p)
+{
+	int k;
+
+	for (k = 0; k < pooled; k++){
+		if (pool[k].p == p){
+			pool[k].used = 0;
+			return;
+		}
+	}
+}
+
+
+
+/*Return every buffer of the pool to the system, those still in use too (at the end of the program)*/
+void emptyPool(void)
+{
+	int k;
+
+	for (k = 0; k < pooled; k++){
+		if (pool[k].mapped) munmap(pool[k].p, pool[k].bytes);
+		else free(pool[k].p);
+	}
+	free(pool);
+	pool     = NULL;
+	pooled   = 0;
+	capacity = 0;
+}
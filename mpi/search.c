@@ -0,0 +1,399 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include "mpi.h"
+#include "gol.h"
+#include "functions.h"
+#include "halo.h"
+#include "loader.h"
+#include "search.h"
+
+
+/*A pattern (or one of its phases) in its bounding box*/
+typedef struct {
+	int  rows, cols;
+	char cells[SEARCH_MAX_SIDE][SEARCH_MAX_SIDE];
+} shape;
+
+/*A phase of a pattern in one of its 8 orientations, as the cells of its window (the pattern with a dead margin one cell wide) to*/
+/*compare, the live ones first (on a sparse board most places fail at the first or the second one)*/
+typedef struct {
+	int  pattern, rows, cols, checks;
+	int  row[(SEARCH_MAX_SIDE+2)*(SEARCH_MAX_SIDE+2)], col[(SEARCH_MAX_SIDE+2)*(SEARCH_MAX_SIDE+2)];
+	char live[(SEARCH_MAX_SIDE+2)*(SEARCH_MAX_SIDE+2)];
+	shape cells;
+} variant;
+
+/*The patterns that are known by their name (o is a live cell, every / starts a new row)*/
+static const struct {
+	const char *name, *cells;
+} library[] = {
+	{"block",   "oo/oo"},
+	{"blinker", "ooo"},
+	{"beehive", ".oo./o..o/.oo."},
+	{"loaf",    ".oo./o..o/.o.o/..o."},
+	{"boat",    "oo./o.o/.o."},
+	{"tub",     ".o./o.o/.o."},
+	{"toad",    ".ooo/ooo."},
+	{"beacon",  "oo../oo../..oo/..oo"},
+	{"glider",  ".o./..o/ooo"},
+	{"lwss",    ".o..o/o..../o...o/oooo."},
+};
+
+int searching = 0;						//Set by searchStart() (-p in cmd)
+
+static char *names[SEARCH_MAX_PATTERNS];
+static int  npatterns = 0, nvariants = 0, room = 0, margin, side, words, rank;
+static variant *variants = NULL;
+static long long *totals;
+static char **pad, *text = NULL;
+static uint64_t *bits;
+static size_t length, capacity;
+static MPI_Datatype halotypes[3];
+static MPI_Comm communicator;
+static MPI_File fp;
+static int  neighbourranks[8];
+
+
+
+/*Read a pattern of the library (e.g. ".o./..o/ooo"), returns -1 if it is larger than SEARCH_MAX_SIDE*/
+static int parseShape(const char *cells, shape *s)
+{
+	int  i = 0, j = 0;
+
+	memset(s, 0, sizeof(shape));
+	for (; *cells != '\0'; cells++){
+		if (*cells == '/'){
+			i++;
+			j = 0;
+			continue;
+		}
+		if ((i >= SEARCH_MAX_SIDE) || (j >= SEARCH_MAX_SIDE)) return -1;
+		s->cells[i][j++] = (*cells == 'o');
+		if (j > s->cols) s->cols = j;
+	}
+	s->rows = i+1;
+	return 0;
+}
+
+
+
+/*Read a pattern from a file of coordinates (as the input files), returns -1 if it cannot be read or it is too large or empty*/
+static int readShape(const char *filename, shape *s)
+{
+	int  i, j, top = INT_MAX, left = INT_MAX, count = 0;
+	int  rows[SEARCH_MAX_SIDE*SEARCH_MAX_SIDE], cols[SEARCH_MAX_SIDE*SEARCH_MAX_SIDE], k;
+	mapped input;
+
+	if (mapInput(filename, &input) != 0) return -1;
+	while (nextCoordinates(&input, &i, &j)){
+		if (count == SEARCH_MAX_SIDE*SEARCH_MAX_SIDE) break;
+		rows[count]   = i;
+		cols[count++] = j;
+		if (i < top) top = i;
+		if (j < left) left = j;
+	}
+	unmapInput(&input);
+
+	memset(s, 0, sizeof(shape));
+	for (k = 0; k < count; k++){
+		i = rows[k] - top;
+		j = cols[k] - left;
+		if ((i >= SEARCH_MAX_SIDE) || (j >= SEARCH_MAX_SIDE)) return -1;
+		s->cells[i][j] = 1;
+		if (i >= s->rows) s->rows = i+1;
+		if (j >= s->cols) s->cols = j+1;
+	}
+	return (count > 0) ? 0 : -1;
+}
+
+
+
+/*The live cells of a g x g grid in their bounding box, returns -1 if there are none or the box is larger than SEARCH_MAX_SIDE*/
+static int cutShape(const char *grid, int g, shape *s)
+{
+	int  i, j, top = g, left = g, bottom = -1, right = -1;
+
+	for (i = 0; i < g; i++){
+		for (j = 0; j < g; j++){
+			if (grid[i*g + j] != 1) continue;
+			if (i < top) top = i;
+			if (j < left) left = j;
+			if (i > bottom) bottom = i;
+			if (j > right) right = j;
+		}
+	}
+	if ((bottom < 0) || (bottom-top >= SEARCH_MAX_SIDE) || (right-left >= SEARCH_MAX_SIDE)) return -1;
+	memset(s, 0, sizeof(shape));
+	s->rows = bottom-top+1;
+	s->cols = right-left+1;
+	for (i = 0; i < s->rows; i++)
+		for (j = 0; j < s->cols; j++)
+			s->cells[i][j] = grid[(top+i)*g + left+j];
+	return 0;
+}
+
+
+
+static int sameShape(const shape *a, const shape *b)
+{
+	int i;
+
+	if ((a->rows != b->rows) || (a->cols != b->cols)) return 0;
+	for (i = 0; i < a->rows; i++)
+		if (memcmp(a->cells[i], b->cells[i], a->cols)) return 0;
+	return 1;
+}
+
+
+
+/*One of the 8 orientations of a shape: t&4 swaps the rows with the columns, then t&1 flips the rows and t&2 the columns*/
+static void orient(const shape *in, int t, shape *out)
+{
+	int  i, j, r, c;
+
+	memset(out, 0, sizeof(shape));
+	out->rows = (t & 4) ? in->cols : in->rows;
+	out->cols = (t & 4) ? in->rows : in->cols;
+	for (i = 0; i < in->rows; i++){
+		for (j = 0; j < in->cols; j++){
+			r = (t & 4) ? j : i;
+			c = (t & 4) ? i : j;
+			if (t & 1) r = out->rows-1 - r;
+			if (t & 2) c = out->cols-1 - c;
+			out->cells[r][c] = in->cells[i][j];
+		}
+	}
+}
+
+
+
+/*Add a phase of a pattern in all its orientations that are not there yet*/
+static void addVariants(int pattern, const shape *s)
+{
+	int  t, k, i, j;
+	shape o;
+	variant *v;
+
+	for (t = 0; t < 8; t++){
+		orient(s, t, &o);
+		for (k = 0; k < nvariants; k++)
+			if ((variants[k].pattern == pattern) && sameShape(&variants[k].cells, &o)) break;
+		if (k < nvariants) continue;
+
+		if (nvariants == room){
+			room = (room > 0) ? 2*room : 16;
+			variants = realloc(variants, room * sizeof(variant));
+		}
+		v = &variants[nvariants++];
+		v->pattern = pattern;
+		v->cells   = o;
+		v->rows    = o.rows+2;
+		v->cols    = o.cols+2;
+		v->checks  = 0;
+		for (k = 1; k >= 0; k--){			//The live cells first, then the dead ones (with the margin)
+			for (i = 0; i < v->rows; i++){
+				for (j = 0; j < v->cols; j++){
+					char live = (i > 0) && (j > 0) && (i <= o.rows) && (j <= o.cols) && o.cells[i-1][j-1];
+					if (live != k) continue;
+					v->row[v->checks]  = i;
+					v->col[v->checks]  = j;
+					v->live[v->checks] = live;
+					v->checks++;
+				}
+			}
+		}
+	}
+}
+
+
+
+/*The phases of a pattern: it evolves alone (with the rule of the board) until a shape comes again, it dies or it grows too much*/
+static void addPattern(int pattern, const shape *s, char rule[2][9])
+{
+	int  g = SEARCH_MAX_SIDE + 2*SEARCH_PHASES + 2, i, k, phases = 1, allzeros, change;
+	char *old = calloc(g*g, sizeof(char)), *new = calloc(g*g, sizeof(char)), *swap;
+	shape found[SEARCH_PHASES+1];
+
+	found[0] = *s;
+	for (i = 0; i < s->rows; i++)
+		memcpy(&old[(SEARCH_PHASES+1 + i)*g + SEARCH_PHASES+1], s->cells[i], s->cols);
+	addVariants(pattern, s);
+	while (phases <= SEARCH_PHASES){
+		allzeros = change = 0;
+		gol_evolve(old, new, g, 1, g-1, 1, g-1, rule, &allzeros, &change);
+		if (cutShape(new, g, &found[phases]) != 0) break;
+		for (k = 0; k < phases; k++)
+			if (sameShape(&found[k], &found[phases])) break;
+		if (k < phases) break;
+		addVariants(pattern, &found[phases++]);
+		swap = old;
+		old  = new;
+		new  = swap;
+	}
+	free(old);
+	free(new);
+}
+
+
+
+/*The patterns to search, separated by commas: names of the library or files of coordinates (e.g. glider,lwss,./"Input Files"/boat)*/
+/*with the rule of the board for their phases, returns -1 if one of them is unknown, cannot be read or is too large*/
+int searchPatterns(const char *list, char rule[2][9])
+{
+	int  k, known;
+	char *copy = malloc(strlen(list) + 1), *name;
+	shape s;
+
+	strcpy(copy, list);
+	for (name = strtok(copy, ","); name != NULL; name = strtok(NULL, ",")){
+		if (npatterns == SEARCH_MAX_PATTERNS) break;
+		known = 0;
+		for (k = 0; k < (int)(sizeof(library) / sizeof(library[0])); k++){
+			if (strcmp(name, library[k].name)) continue;
+			known = (parseShape(library[k].cells, &s) == 0);
+			break;
+		}
+		if (!known && (readShape(name, &s) != 0)){
+			free(copy);
+			return -1;
+		}
+		names[npatterns] = malloc(strlen(name) + 1);
+		strcpy(names[npatterns], name);
+		addPattern(npatterns++, &s, rule);
+	}
+	free(copy);
+	return (npatterns > 0) ? 0 : -1;
+}
+
+
+
+/*Start the search in the n x n block of every process, every occurrence goes to the file (generation,pattern,row,column of the*/
+/*bounding box). Returns -1 if the file cannot be written, -2 if the blocks are narrower than the largest pattern*/
+int searchStart(const char *filename, int n, int neighbours[8], int my_rank, MPI_Comm comm)
+{
+	int  k;
+
+	margin = 1;
+	for (k = 0; k < nvariants; k++){
+		if (variants[k].rows-2 > margin) margin = variants[k].rows-2;
+		if (variants[k].cols-2 > margin) margin = variants[k].cols-2;
+	}
+	if (n < margin) return -2;
+
+	/*A communicator of its own, so the halo of the search never meets a halo of the generations that is still in flight*/
+	MPI_Comm_dup(comm, &communicator);
+	if (MPI_File_open(communicator, (char *)filename, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fp) != MPI_SUCCESS){
+		MPI_Comm_free(&communicator);
+		return -1;
+	}
+	MPI_File_set_size(fp, 0);
+
+	rank  = my_rank;
+	side  = n;
+	words = (n + 2*margin + 63) / 64 + 1;			//One word more, so a window of 64 cells is always in the row
+	memcpy(neighbourranks, neighbours, sizeof(neighbourranks));
+	pad    = allocateArray(n + 2*margin, 0);
+	bits   = calloc((size_t)(n + 2*margin) * words, sizeof(uint64_t));
+	totals = calloc(npatterns, sizeof(long long));
+	createHaloTypes(n, margin, halotypes);
+	capacity = 4096;
+	text     = malloc(capacity);
+	length   = (rank == 0) ? sprintf(text, "generation,pattern,row,column\n") : 0;
+	searching = 1;
+	return 0;
+}
+
+
+
+/*The 64 cells of a packed row from column c on (cell c in bit 0)*/
+static inline uint64_t window(const uint64_t *row, int c)
+{
+	int w = c >> 6, s = c & 63;
+
+	return s ? (row[w] >> s) | (row[w+1] << (64-s)) : row[w];
+}
+
+
+
+/*Find every pattern in the block of this process at a generation (row0 and col0 are the place of its first cell in the board). The*/
+/*block gets a halo as wide as the largest pattern from its 8 neighbours, so a pattern is found by the process of its first row and*/
+/*column even if it reaches out of the block. The cells are packed in 64 bit words and every word of a window is compared for 64*/
+/*places at once*/
+void searchBlock(int generation, char **blocks, int frame, int row0, int col0)
+{
+	int  i, j, k, b, t, v, n = side, m = margin;
+	uint64_t match, valid, *r;
+	MPI_Request request[16];
+	variant *p;
+
+	for (i = 0; i < n; i++)
+		memcpy(&pad[m+i][m], &blocks[frame+i][frame], n);
+	exchangeHalo(pad, n, m, neighbourranks, halotypes, communicator, request);
+	MPI_Waitall(16, request, MPI_STATUSES_IGNORE);
+
+	memset(bits, 0, (size_t)(n + 2*m) * words * sizeof(uint64_t));
+	for (i = 0; i < n + 2*m; i++){
+		r = bits + (size_t)i*words;
+		for (j = 0; j < n + 2*m; j++)
+			r[j >> 6] |= (uint64_t)(pad[i][j] == 1) << (j & 63);
+	}
+
+	/*The window of a pattern at (i, b+t) starts one cell up and left of it, in the halo if the pattern is on the first row or column*/
+	for (i = 0; i < n; i++){
+		for (b = 0; b < n; b += 64){
+			valid = (n - b >= 64) ? ~0ULL : (1ULL << (n - b)) - 1;
+			for (v = 0; v < nvariants; v++){
+				p = &variants[v];
+				match = valid;
+				for (k = 0; (k < p->checks) && match; k++){
+					r = bits + (size_t)(m + i - 1 + p->row[k])*words;
+					match &= p->live[k] ? window(r, m + b - 1 + p->col[k]) : ~window(r, m + b - 1 + p->col[k]);
+				}
+				for (; match; match &= match - 1){
+					t = __builtin_ctzll(match);
+					if (length + 64 + strlen(names[p->pattern]) > capacity){
+						capacity *= 2;
+						text = realloc(text, capacity);
+					}
+					length += sprintf(text + length, "%d,%s,%d,%d\n", generation, names[p->pattern], row0 + i, col0 + b + t);
+					totals[p->pattern]++;
+				}
+			}
+		}
+	}
+
+	/*Every process writes its occurrences after the ones of the processes before it*/
+	MPI_File_write_ordered(fp, text, (int)length, MPI_CHAR, MPI_STATUS_IGNORE);
+	length = 0;
+}
+
+
+
+/*Close the file and print how many times every pattern was found in all the generations searched*/
+void searchFinish(void)
+{
+	int  k;
+	long long *all;
+
+	if (!searching) return;
+	all = malloc(npatterns * sizeof(long long));
+	MPI_Reduce(totals, all, npatterns, MPI_LONG_LONG, MPI_SUM, 0, communicator);
+	if (rank == 0)
+		for (k = 0; k < npatterns; k++)
+			printf("Found %s = %lld\n", names[k], all[k]);
+	MPI_File_close(&fp);
+	freeHaloTypes(halotypes);
+	MPI_Comm_free(&communicator);
+	deleteArray(&pad);
+	for (k = 0; k < npatterns; k++)
+		free(names[k]);
+	free(all);
+	free(bits);
+	free(totals);
+	free(text);
+	free(variants);
+	searching = 0;
+}
@@ -0,0 +1,20 @@
+#ifndef __search__
+#define __search__
+
+#include "mpi.h"
+
+
+#define SEARCH_MAX_PATTERNS 32			//Patterns of one search
+#define SEARCH_MAX_SIDE     16			//Largest side of a pattern (and of its phases)
+#define SEARCH_PHASES       16			//Most generations a pattern is evolved to find its phases
+
+extern int searching;
+
+
+int  searchPatterns(const char *list, char rule[2][9]);
+int  searchStart(const char *filename, int n, int neighbours[8], int my_rank, MPI_Comm comm);
+void searchBlock(int generation, char **blocks, int frame, int row0, int col0);
+void searchFinish(void);
+
+
+#endif
@@ -0,0 +1,448 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <omp.h>
+#include "mpi.h"
+#include "gol.h"
+#include "memory.h"
+#include "halo.h"
+#include "tasks.h"
+
+
+/*A tile of the block of the process, with the cells of the even and of the odd generations (each one with its own ghost frame)*/
+typedef struct {
+	char **cells[2];
+	int  pending[2];			//What the next generation from cells[p] still waits for: the 8 halos, its own cells and the sends of cells[1-p]
+	int  generation;			//Last generation it computed
+	int  neighbour[8];			//Index of the neighbour tiles in their process (clockwise from upleft, as in halo.c)
+	int  owner[8];				//Process of the neighbour tiles
+	int  remote;				//Neighbours in other processes
+	int  home;					//Thread whose deque gets the tile when a message releases it
+} tile;
+
+/*The ready tiles of a thread: it takes the last one it put (its cells are still in its cache), the other threads steal the first one*/
+typedef struct {
+	int  *items, first, last;	//last-first tiles, in items[first % ntiles] ... items[(last-1) % ntiles]
+	omp_lock_t lock;
+} deque;
+
+static tile  *tiles;
+static deque *deques;
+static int  ntiles, size, last, threadcount, rank, finished;
+static char (*rules)[9];
+static char *slab[2];				//The cells of all the tiles, for the even and the odd generations
+static long *keys;
+
+/*Tiles with remote neighbours whose generation is computed, for the main thread to send their sides (only it calls MPI)*/
+static int  *eventtile, *eventgen, eventfirst, eventlast;
+static omp_lock_t eventlock;
+
+/*The requests of the halos of every tile, from every direction (receives) or to it (sends), for the even and the odd generations*/
+static MPI_Request *requests;
+static int  nrequests, *completed;
+static MPI_Datatype halotypes[3];
+static MPI_Comm communicator;
+
+/*Where the border sent towards neighbour d starts, where the ghost part received from the opposite neighbour starts and its type*/
+static int  row[8], col[8], grow[8], gcol[8];
+static const int type[8] = {2, 0, 2, 1, 2, 0, 2, 1};
+static const int dr[8]   = {-1, -1, -1, 0, 1, 1, 1, 0};
+static const int dc[8]   = {-1, 0, 1, 1, 1, 0, -1, -1};
+
+
+
+static int slot(int t, int d, int sending, int p)
+{
+	return ((t*8 + d)*2 + sending)*2 + p;
+}
+
+
+
+/*The tag of the halo that tile t receives from direction d, for the even or the odd generations*/
+static int tag(int t, int d, int p)
+{
+	return (t*8 + d)*2 + p;
+}
+
+
+
+static void push(int thread, int t)
+{
+	deque *q = &deques[thread];
+
+	omp_set_lock(&q->lock);
+	q->items[q->last++ % ntiles] = t;
+	omp_unset_lock(&q->lock);
+}
+
+
+
+/*The last tile the thread put in its deque, or else the first one of another thread (returns -1 if there is none)*/
+static int take(int thread)
+{
+	int  k, t = -1;
+	deque *q;
+
+	for (k = 0; (t < 0) && (k < threadcount); k++){
+		q = &deques[(thread + k) % threadcount];
+		omp_set_lock(&q->lock);
+		if (q->last > q->first) t = (k == 0) ? q->items[--q->last % ntiles] : q->items[q->first++ % ntiles];
+		if (q->last == q->first) q->first = q->last = 0;
+		omp_unset_lock(&q->lock);
+	}
+	return t;
+}
+
+
+
+/*One of the things tile t waits for before the generation from cells[p] is done, the last one puts it in the deque of the thread*/
+static void release(int t, int p, int thread)
+{
+	int left;
+
+	#	pragma omp atomic capture seq_cst
+	left = --tiles[t].pending[p];
+	if (left == 0) push(thread, t);
+}
+
+
+
+static void postEvent(int t, int g)
+{
+	omp_set_lock(&eventlock);
+	eventtile[eventlast % (2*ntiles)] = t;
+	eventgen[eventlast % (2*ntiles)]  = g;
+	eventlast++;
+	omp_unset_lock(&eventlock);
+}
+
+
+
+static int takeEvent(int *t, int *g)
+{
+	int found = 0;
+
+	omp_set_lock(&eventlock);
+	if (eventlast > eventfirst){
+		*t = eventtile[eventfirst % (2*ntiles)];
+		*g = eventgen[eventfirst % (2*ntiles)];
+		eventfirst++;
+		found = 1;
+	}
+	if (eventlast == eventfirst) eventfirst = eventlast = 0;
+	omp_unset_lock(&eventlock);
+	return found;
+}
+
+
+
+/*Copy the border of a tile towards its neighbour d in the ghost frame of the neighbour*/
+static void copyBorder(char **from, char **to, int d)
+{
+	int  i, rows = (type[d] == 1) ? size : 1, cols = (type[d] == 0) ? size : 1;
+
+	for (i = 0; i < rows; i++)
+		memcpy(&to[grow[d] + i][gcol[d]], &from[row[d] + i][col[d]], cols);
+}
+
+
+
+/*Post the receives of the halos of generation g of a tile from the other processes (straight in its ghost frame)*/
+static void postReceives(int t, int g)
+{
+	int  d, p = g % 2;
+	tile *a = &tiles[t];
+
+	for (d = 0; d < 8; d++){
+		if (a->owner[d] == rank) continue;
+		MPI_Irecv(&(a->cells[p][grow[(d+4)%8]][gcol[(d+4)%8]]), 1, halotypes[type[d]], a->owner[d], tag(t, d, p), communicator, &requests[slot(t, d, 0, p)]);
+	}
+}
+
+
+
+/*Send the sides of generation g of a tile to the other processes, and post the receives of the next generation*/
+static void communicate(int t, int g)
+{
+	int  d, p = g % 2;
+	tile *a = &tiles[t];
+
+	for (d = 0; d < 8; d++){
+		if (a->owner[d] == rank) continue;
+		MPI_Isend(&(a->cells[p][row[d]][col[d]]), 1, halotypes[type[d]], a->owner[d], tag(a->neighbour[d], (d+4)%8, p), communicator, &requests[slot(t, d, 1, p)]);
+	}
+	if (g+1 < last) postReceives(t, g+1);
+}
+
+
+
+/*Compute the next generation of a tile and hand its sides to the neighbours: the tiles of the process get them in their ghost*/
+/*frame at once, the others through the main thread*/
+static void advance(int t, int thread)
+{
+	int  d, g = tiles[t].generation, p = g % 2, allzeros = 0, change = 0;
+	tile *a = &tiles[t];
+
+	#	pragma omp atomic write seq_cst
+	a->pending[p] = 9 + a->remote;			//For the generation after the next one
+	gol_evolve(&(a->cells[p][0][0]), &(a->cells[1-p][0][0]), size+2, 1, size+1, 1, size+1, rules, &allzeros, &change);
+	a->generation = g+1;
+	if (g+1 == last){
+		#	pragma omp atomic update
+		finished++;
+		return;
+	}
+
+	for (d = 0; d < 8; d++){
+		if (a->owner[d] != rank) continue;
+		copyBorder(a->cells[1-p], tiles[a->neighbour[d]].cells[1-p], d);
+		release(a->neighbour[d], 1-p, thread);
+	}
+	if (a->remote > 0) postEvent(t, g+1);
+	release(t, 1-p, thread);
+}
+
+
+
+/*Send the sides of the tiles that are done and test the requests, a received halo or a finished send releases its tile*/
+/*(returns how much was done)*/
+static int progress(void)
+{
+	int  k, t, g, d, count, done = 0;
+
+	while (takeEvent(&t, &g)){
+		communicate(t, g);
+		done++;
+	}
+	MPI_Testsome(nrequests, requests, &count, completed, MPI_STATUSES_IGNORE);
+	if (count == MPI_UNDEFINED) return done;
+	for (k = 0; k < count; k++){
+		t = completed[k] / 32;
+		d = completed[k] % 32;
+		release(t, ((d / 2) % 2) ? 1 - (d % 2) : d % 2, tiles[t].home);		//A send of cells[p] releases the generation from cells[1-p]
+	}
+	return done + count;
+}
+
+
+
+/*The work of a thread until all the tiles reach the last generation (the main thread takes a tile only when no message is moving)*/
+static void work(int thread)
+{
+	int  t, done;
+
+	for (;;){
+		#	pragma omp atomic read seq_cst
+		done = finished;
+		if ((thread == 0) && (progress() > 0)) continue;		//The sides of the last tiles are sent before it stops
+		if (done == ntiles) return;
+
+		t = take(thread);
+		if (t >= 0) advance(t, thread);
+		else sched_yield();
+	}
+}
+
+
+
+/*Place of tile (a, b) along the Z-order (Morton) curve: the bits of a and b interleaved*/
+static long mortonKey(int a, int b)
+{
+	int  k;
+	long key = 0;
+
+	for (k = 0; k < 16; k++)
+		key |= ((long)((b >> k) & 1) << (2*k)) | ((long)((a >> k) & 1) << (2*k+1));
+	return key;
+}
+
+
+
+/*Place of tile (a, b) along the Hilbert curve of n x n tiles (n a power of 2): the quadrant of every level, with the quadrants*/
+/*turned so that the curve goes on from the one before*/
+static long hilbertKey(int a, int b, int n)
+{
+	int  s, rx, ry, x = b, y = a, swap;
+	long key = 0;
+
+	for (s = n/2; s > 0; s /= 2){
+		rx = (x & s) > 0;
+		ry = (y & s) > 0;
+		key += (long)s*s*((3*rx) ^ ry);
+		if (ry == 0){
+			if (rx == 1){
+				x = n-1 - x;
+				y = n-1 - y;
+			}
+			swap = x;
+			x    = y;
+			y    = swap;
+		}
+	}
+	return key;
+}
+
+
+
+static int compareKeys(const void *a, const void *b)
+{
+	long ka = keys[*(const int *)a], kb = keys[*(const int *)b];
+
+	return (ka > kb) - (ka < kb);
+}
+
+
+
+/*The tiles of a side x side grid in the order they are stored: row by row, or along the Z-order or the Hilbert curve (the grid*/
+/*is put in the smallest power of 2 that holds it, and the places out of it are skipped)*/
+static int *tileOrder(int side, int layout)
+{
+	int  t, n = 1, *order = malloc(side*side * sizeof(int));
+
+	while (n < side) n *= 2;
+	keys = malloc(side*side * sizeof(long));
+	for (t = 0; t < side*side; t++){
+		order[t] = t;
+		if (layout == TILES_MORTON) keys[t] = mortonKey(t / side, t % side);
+		else if (layout == TILES_HILBERT) keys[t] = hilbertKey(t / side, t % side, n);
+		else keys[t] = t;
+	}
+	qsort(order, side*side, sizeof(int), compareKeys);
+	free(keys);
+	return order;
+}
+
+
+
+/*Over-decomposition - the n x n block (with a ghost frame one cell wide) is cut in side x side tiles, and every tile computes its*/
+/*next generation as soon as its own cells and the halos of its 8 neighbours are there, in the tasks of a pool of threads that steal*/
+/*the ready tiles from each other. There is no step of all the processes together, so a slow process or tile holds up only the*/
+/*tiles next to it. The tiles are stored one after the other in the order of the layout (rows, Z-order or Hilbert curve). The block*/
+/*gets the cells of the last generation (generations-1 steps)*/
+void runTiles(char **blocks, int n, int side, int layout, int threads, int generations, char rule[2][9], int my_rank, int SideProcesses, MPI_Comm comm)
+{
+	int  i, j, k, p, t, d, a, b, gr, gc, board = SideProcesses*side, *order;
+	int  R = my_rank / SideProcesses, C = my_rank % SideProcesses;
+	size_t tilebytes;
+	tile *x;
+
+	if (generations < 2) return;
+	ntiles       = side*side;
+	size         = n / side;
+	last         = generations-1;
+	threadcount  = threads;
+	rank         = my_rank;
+	rules        = rule;
+	communicator = comm;
+	finished     = 0;
+
+	/*The same places as in exchangeHalo(), for a tile of size x size cells*/
+	int  places[4][8] = {{1, 1, 1, 1, size, size, size, 1}, {1, 1, size, size, size, 1, 1, 1},
+						{size+1, size+1, size+1, 1, 0, 0, 0, 1}, {size+1, 1, 0, 0, 0, 1, size+1, size+1}};
+	memcpy(row, places[0], sizeof(row));
+	memcpy(col, places[1], sizeof(col));
+	memcpy(grow, places[2], sizeof(grow));
+	memcpy(gcol, places[3], sizeof(gcol));
+
+	/*Every tile (with its frame) is contiguous from a cache line, and the tiles are stored in the order of the curve of the layout,*/
+	/*so the tiles next to each other on the board are close in memory (the same pages), and the tiles of a thread are a piece of*/
+	/*the curve. The main thread keeps to the messages if there are other threads*/
+	order     = tileOrder(side, layout);
+	tilebytes = ((size_t)(size+2)*(size+2) + CELL_ALIGN-1) / CELL_ALIGN * CELL_ALIGN;
+	tiles     = malloc(ntiles * sizeof(tile));
+	for (p = 0; p < 2; p++){
+		slab[p] = allocateCells(ntiles * tilebytes);
+		memset(slab[p], 0, ntiles * tilebytes);
+	}
+	for (k = 0; k < ntiles; k++){
+		x = &tiles[order[k]];
+		x->home = (threadcount > 1) ? 1 + (int)((long)k*(threadcount-1) / ntiles) : 0;
+		for (p = 0; p < 2; p++){
+			x->cells[p] = malloc((size+2) * sizeof(char *));
+			for (i = 0; i < size+2; i++)
+				x->cells[p][i] = slab[p] + k*tilebytes + (size_t)i*(size+2);
+		}
+	}
+
+	/*The neighbours of the tiles on the board (a torus of board x board tiles) and the cells of the block*/
+	for (a = 0; a < side; a++){
+		for (b = 0; b < side; b++){
+			x = &tiles[a*side + b];
+			x->generation = 0;
+			x->remote     = 0;
+			for (d = 0; d < 8; d++){
+				gr = (R*side + a + dr[d] + board) % board;
+				gc = (C*side + b + dc[d] + board) % board;
+				x->owner[d]     = (gr / side)*SideProcesses + gc / side;
+				x->neighbour[d] = (gr % side)*side + gc % side;
+				x->remote      += (x->owner[d] != rank);
+			}
+			x->pending[0] = 9;						//The first generation waits for no send
+			x->pending[1] = 9 + x->remote;
+			for (i = 0; i < size; i++)
+				memcpy(&(x->cells[0][i+1][1]), &blocks[1 + a*size + i][1 + b*size], size);
+		}
+	}
+
+	deques = malloc(threadcount * sizeof(deque));
+	for (i = 0; i < threadcount; i++){
+		deques[i].items = malloc(ntiles * sizeof(int));
+		deques[i].first = deques[i].last = 0;
+		omp_init_lock(&deques[i].lock);
+	}
+	eventtile  = malloc(2*ntiles * sizeof(int));
+	eventgen   = malloc(2*ntiles * sizeof(int));
+	eventfirst = eventlast = 0;
+	omp_init_lock(&eventlock);
+
+	nrequests = 32*ntiles;
+	requests  = malloc(nrequests * sizeof(MPI_Request));
+	completed = malloc(nrequests * sizeof(int));
+	for (i = 0; i < nrequests; i++)
+		requests[i] = MPI_REQUEST_NULL;
+	createHaloTypes(size, 1, halotypes);
+
+	/*Generation 0 of every tile is there: the halos from the other processes are awaited and the sides are handed to the neighbours*/
+	for (t = 0; t < ntiles; t++)
+		postReceives(t, 0);
+	for (k = 0; k < ntiles; k++){
+		t = order[k];
+		for (d = 0; d < 8; d++){
+			if (tiles[t].owner[d] != rank) continue;
+			copyBorder(tiles[t].cells[0], tiles[tiles[t].neighbour[d]].cells[0], d);
+			release(tiles[t].neighbour[d], 0, tiles[tiles[t].neighbour[d]].home);
+		}
+		if (tiles[t].remote > 0) postEvent(t, 0);
+		release(t, 0, tiles[t].home);
+	}
+
+	#	pragma omp parallel num_threads(threadcount)
+	work(omp_get_thread_num());
+	MPI_Waitall(nrequests, requests, MPI_STATUSES_IGNORE);		//The last sends
+
+	/*The cells of the last generation go back to the block*/
+	for (t = 0; t < ntiles; t++){
+		a = t / side;
+		b = t % side;
+		for (j = 0; j < size; j++)
+			memcpy(&blocks[1 + a*size + j][1 + b*size], &(tiles[t].cells[last % 2][j+1][1]), size);
+		free(tiles[t].cells[0]);
+		free(tiles[t].cells[1]);
+	}
+	releaseCells(slab[0]);
+	releaseCells(slab[1]);
+	free(order);
+	for (i = 0; i < threadcount; i++){
+		free(deques[i].items);
+		omp_destroy_lock(&deques[i].lock);
+	}
+	omp_destroy_lock(&eventlock);
+	freeHaloTypes(halotypes);
+	free(deques);
+	free(tiles);
+	free(eventtile);
+	free(eventgen);
+	free(requests);
+	free(completed);
+}
@@ -0,0 +1,18 @@
+#ifndef __tasks__
+#define __tasks__
+
+#include "mpi.h"
+
+
+#define TASKS_MAX_SIDE 32				//Most tiles along each side of a block (the tags of the halos of all tiles must fit in MPI_TAG_UB)
+
+/*Order of the tiles in memory (-L in cmd)*/
+#define TILES_ROWS    0
+#define TILES_MORTON  1
+#define TILES_HILBERT 2
+
+
+void runTiles(char **blocks, int n, int side, int layout, int threads, int generations, char rule[2][9], int my_rank, int SideProcesses, MPI_Comm comm);
+
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef __trace__
+#define __trace__
+
+#include "mpi.h"
+
+
+/*The phases of a generation in the MPI programs, each one is timed from the end of the previous one*/
+enum {TRACE_HALO, TRACE_INNER, TRACE_WAIT, TRACE_SIDES, TRACE_REDUCE, TRACE_OUTPUT, TRACE_PHASES};
+
+extern int tracing;
+
+/*Without -T the macros cost only the test of tracing, and with -DNOTRACE they are not compiled at all*/
+#ifdef NOTRACE
+#define TRACE_MARK(t)                     (void)(t)
+#define TRACE_PHASE(phase, generation, t) (void)(t)
+#else
+#define TRACE_MARK(t)                     do { if (tracing) (t) = MPI_Wtime(); } while (0)
+#define TRACE_PHASE(phase, generation, t) do { if (tracing) (t) = tracePhase(phase, generation, t); } while (0)
+#endif
+
+
+void traceStart(const char *filename, int generations, double origin);
+double tracePhase(int phase, int generation, double since);
+void traceFinish(MPI_Comm comm, int my_rank, int processes);
+
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef __unbounded__
+#define __unbounded__
+
+#include <stdint.h>
+
+
+#define CHUNK_SIZE 64
+
+
+/*A 64 x 64 chunk of the plane, every row is a bitboard (bit j is column j of the chunk)*/
+typedef struct chunk {
+	long     ci, cj;					//Position of the chunk (row, column) in chunk units
+	uint64_t cells[CHUNK_SIZE];
+	uint64_t next[CHUNK_SIZE];
+} chunk;
+
+/*The unbounded plane, only chunks with live cells (or next to live cells) are allocated*/
+typedef struct universe {
+	chunk **chunks;						//Allocated chunks, in no particular order
+	int   count, allocated;
+	chunk **table;						//Open addressing hash map from position to chunk
+	int   tablesize;					//Power of 2, at least twice the chunks
+} universe;
+
+
+int checkUnboundedRule(char rule[2][9]);
+universe *createUniverse(void);
+void deleteUniverse(universe **u);
+chunk *findChunk(universe *u, long ci, long cj);
+void setCellUnbounded(universe *u, long i, long j);
+int getCellUnbounded(universe *u, long i, long j);
+long population(universe *u);
+int boundingBox(universe *u, long box[4]);
+void showUnbounded(universe *u);
+void evolveUnbounded(universe *u, char rule[2][9], int *allzeros, int *change);
+
+
+#endif
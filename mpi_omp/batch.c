@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "batch.h"
+#include "memory.h"
+
+
+
+/*Allocate the boards of a batch in groups of 64, every group is an N x N array of words (bit b of a word is the cell of board b)*/
+uint64_t *allocateGroups(int groups, int N)
+{
+	uint64_t *cells = allocateCells((size_t)groups*N*N * sizeof(uint64_t));
+
+	if (cells != NULL) memset(cells, 0, (size_t)groups*N*N * sizeof(uint64_t));
+	return cells;
+}
+
+
+
+/*Delete the boards of a batch (their memory waits in the pool for the next batch)*/
+void deleteGroups(uint64_t *cells)
+{
+	releaseCells(cells);
+}
+
+
+
+/*Read the live cells of the boards from a file with lines "board row column" (returns -1 if a line is out of range)*/
+int readBatch(FILE *fp, uint64_t *cells, int N, int boards)
+{
+	int  b, i, j;
+	char line[64];
+
+	while (fgets(line, 64, fp) != NULL){
+		if (sscanf(line, "%d %d %d", &b, &i, &j) != 3) continue;
+		if ((b < 0) || (b >= boards) || (i < 0) || (i >= N) || (j < 0) || (j >= N)) return -1;
+		cells[(size_t)(b / BATCH_LANES)*N*N + i*N + j] |= (uint64_t)1 << (b % BATCH_LANES);
+	}
+	return 0;
+}
+
+
+
+/*Initialize the boards randomly (the same seed gives the same boards, whichever process or thread evolves them)*/
+void randomBatch(uint64_t *cells, int N, int boards)
+{
+	int    g, k, groups = (boards + BATCH_LANES - 1) / BATCH_LANES;
+	uint64_t lanes;
+
+	for (g = 0; g < groups; g++){
+		lanes = (boards - g*BATCH_LANES >= BATCH_LANES) ? ~(uint64_t)0 : ((uint64_t)1 << (boards - g*BATCH_LANES)) - 1;
+		for (k = 0; k < N*N; k++)
+			cells[(size_t)g*N*N + k] = (((uint64_t)rand() << 42) ^ ((uint64_t)rand() << 21) ^ (uint64_t)rand()) & lanes;
+	}
+}
+
+
+
+/*Add a word of neighbours to the bit-sliced counters, s0..s3 are the 4 bits of the 64 counts (at most 8)*/
+#define ADD_NEIGHBOURS(a) { carry = s0 & (a); s0 ^= (a); carry2 = s1 & carry; s1 ^= carry; s3 |= s2 & carry2; s2 ^= carry2; }
+
+
+
+/*The rows and the columns around every row and column of an N x N group on the torus (up and down as offsets of rows, then left and*/
+/*right), so that there are no modulos in the sweep*/
+int *groupNeighbours(int N)
+{
+	int  i, *around = malloc(4*N * sizeof(int));
+
+	for (i = 0; i < N; i++){
+		around[i]       = ((i-1+N) % N) * N;
+		around[N + i]   = ((i+1) % N) * N;
+		around[2*N + i] = (i-1+N) % N;
+		around[3*N + i] = (i+1) % N;
+	}
+	return around;
+}
+
+
+
+/*One generation of a group: the boards of active evolve from old_gen to new_gen and the others keep their cells. anyalive, changed*/
+/*and period2 get one bit for every board with a live cell, that changed and that differs from prev_gen (not checked if it is NULL)*/
+void step_group(const uint64_t *old_gen, uint64_t *new_gen, const uint64_t *prev_gen, int N, const int *around, char rule[2][9], uint64_t active, uint64_t *anyalive, uint64_t *changed, uint64_t *period2)
+{
+	int      i, j, n;
+	const int *up = around, *down = around + N, *left = around + 2*N, *right = around + 3*N;
+	uint64_t s0, s1, s2, s3, carry, carry2, cell, next, eq, alive = 0, change = 0, differ = 0;
+
+	for (i = 0; i < N; i++){
+		for (j = 0; j < N; j++){
+			s0 = s1 = s2 = s3 = 0;
+			ADD_NEIGHBOURS(old_gen[up[i] + left[j]]);
+			ADD_NEIGHBOURS(old_gen[up[i] + j]);
+			ADD_NEIGHBOURS(old_gen[up[i] + right[j]]);
+			ADD_NEIGHBOURS(old_gen[i*N + left[j]]);
+			ADD_NEIGHBOURS(old_gen[i*N + right[j]]);
+			ADD_NEIGHBOURS(old_gen[down[i] + left[j]]);
+			ADD_NEIGHBOURS(old_gen[down[i] + j]);
+			ADD_NEIGHBOURS(old_gen[down[i] + right[j]]);
+
+			/*Every count the rule gives a live cell for selects the boards with that count, all 64 at once*/
+			cell = old_gen[i*N + j];
+			next = 0;
+			for (n = 0; n < 9; n++){
+				if (!rule[0][n] && !rule[1][n]) continue;
+				eq    = ((n & 1) ? s0 : ~s0) & ((n & 2) ? s1 : ~s1) & ((n & 4) ? s2 : ~s2) & ((n & 8) ? s3 : ~s3);
+				next |= eq & ((rule[0][n] ? ~cell : 0) | (rule[1][n] ? cell : 0));
+			}
+			next = (next & active) | (cell & ~active);			//The boards that have stopped keep their cells
+			new_gen[i*N + j] = next;
+
+			alive  |= next;
+			change |= next ^ cell;
+			if (prev_gen != NULL) differ |= next ^ prev_gen[i*N + j];
+		}
+	}
+	*anyalive = alive;
+	*changed  = change;
+	*period2  = differ;
+}
+
+
+
+/*Evolve a group of up to 64 boards together, every board stops on its own when it dies, stops changing or repeats with period 2*/
+/*ended[b] is the generation board b stopped at, status[b] how (BATCH_DIED etc) and alive[b] its live cells in the end*/
+void evolve_group(uint64_t *cells, int N, int lanes, int generations, char rule[2][9], int *ended, int *status, int *alive)
+{
+	int      q, i, b, *around;
+	uint64_t *old_gen = cells, *new_gen, *prev_gen, *swap, *buffers, next;
+	uint64_t active, anyalive, changed, period2, stopped;
+
+	buffers = malloc(2*(size_t)N*N * sizeof(uint64_t));
+	new_gen  = buffers;
+	prev_gen = buffers + (size_t)N*N;
+	around   = groupNeighbours(N);
+
+	active = (lanes >= BATCH_LANES) ? ~(uint64_t)0 : ((uint64_t)1 << lanes) - 1;
+	for (b = 0; b < lanes; b++){
+		ended[b]  = generations - 1;
+		status[b] = BATCH_RUNNING;
+	}
+
+	for (q = 0; (q < generations-1) && (active != 0); q++)
+	{
+		/*anyalive is like allzeros and changed like change, one bit for every board, period2 compares with two generations before*/
+		step_group(old_gen, new_gen, (q > 0) ? prev_gen : NULL, N, around, rule, active, &anyalive, &changed, &period2);
+
+		/*The boards that stop in this generation*/
+		stopped = active & ~(anyalive & changed & ((q > 0) ? period2 : ~(uint64_t)0));
+		for (b = 0; b < lanes; b++){
+			if (!((stopped >> b) & 1)) continue;
+			ended[b] = q + 1;
+			if (!((anyalive >> b) & 1)) status[b] = BATCH_DIED;
+			else if (!((changed >> b) & 1)) status[b] = BATCH_STILL;
+			else status[b] = BATCH_PERIOD2;
+		}
+		active &= ~stopped;
+
+		swap     = prev_gen;
+		prev_gen = old_gen;
+		old_gen  = new_gen;
+		new_gen  = swap;
+	}
+
+	/*Keep the last generation in the group and count the live cells of every board*/
+	if (old_gen != cells) memcpy(cells, old_gen, (size_t)N*N * sizeof(uint64_t));
+	for (b = 0; b < lanes; b++)
+		alive[b] = 0;
+	for (i = 0; i < N*N; i++){
+		for (next = cells[i]; next != 0; next &= next - 1)
+			alive[__builtin_ctzll(next)]++;
+	}
+
+	free(buffers);
+	free(around);
+}
+
+
+
+/*Print how many boards died, stopped changing, repeat with period 2 or kept running (and how every board ended if details is set)*/
+void showBatch(int boards, int *ended, int *status, int *alive, int details)
+{
+	int  b, count[4] = {0, 0, 0, 0};
+	char *name[4] = {"running", "died", "still", "period 2"};
+
+	printf("\n///////////////////////////////////////////////////\n\n");
+	for (b = 0; b < boards; b++){
+		count[status[b]]++;
+		if (details) printf("Board %d: %s at generation %d, %d live cells\n", b, name[status[b]], ended[b], alive[b]);
+	}
+	if (details) printf("\n");
+	printf("Boards %d: died %d, still %d, period 2 %d, running %d\n", boards, count[BATCH_DIED], count[BATCH_STILL], count[BATCH_PERIOD2], count[BATCH_RUNNING]);
+}
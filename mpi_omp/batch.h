@@ -0,0 +1,27 @@
+#ifndef __batch__
+#define __batch__
+
+#include <stdio.h>
+#include <stdint.h>
+
+
+#define BATCH_LANES 64				//Boards of a group, one in every bit of a word
+
+/*How a board of the batch ended*/
+#define BATCH_RUNNING 0				//Still changing after all the generations
+#define BATCH_DIED    1				//All cells are 0
+#define BATCH_STILL   2				//Same as the previous generation
+#define BATCH_PERIOD2 3				//Same as two generations before
+
+
+uint64_t *allocateGroups(int groups, int N);
+void deleteGroups(uint64_t *cells);
+int readBatch(FILE *fp, uint64_t *cells, int N, int boards);
+void randomBatch(uint64_t *cells, int N, int boards);
+int *groupNeighbours(int N);
+void step_group(const uint64_t *old_gen, uint64_t *new_gen, const uint64_t *prev_gen, int N, const int *around, char rule[2][9], uint64_t active, uint64_t *anyalive, uint64_t *changed, uint64_t *period2);
+void evolve_group(uint64_t *cells, int N, int lanes, int generations, char rule[2][9], int *ended, int *status, int *alive);
+void showBatch(int boards, int *ended, int *status, int *alive, int details);
+
+
+#endif
@@ -1,6 +1,11 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <omp.h>
+#include "batch.h"
+#include "gol.h"
+#include "functions.h"
+#include "memory.h"
 
 
 
@@ -10,7 +15,7 @@ char **allocateArray(int n, int init_flag)
 	int  i, j;
 	char *p, **array;
 
-	p = malloc(n*n*sizeof(char));		//Allocate an 1D array of n*n contiguous chunks
+	p = allocateCells((size_t)n*n*sizeof(char));		//An 1D array of n*n contiguous chunks (aligned, from the pool, huge pages if large)
 	array = malloc(n*sizeof(char*));
 	for (i = 0; i < n; i++){			//Allocate a pointers array that points every row of the above 1D array
 		array[i] = &(p[i*n]);			//Just like a usual dynamically allocated 2D array
@@ -27,7 +32,7 @@ char **allocateArray(int n, int init_flag)
 /*Delete a 2D array created in the way above*/
 void deleteArray(char ***array)
 {
-	free(&((*array)[0][0]));			//Delete the initial 1D array with n*n items
+	releaseCells(&((*array)[0][0]));	//Give the initial 1D array with n*n items back to the pool
 	free(*array);						//Delete the pointers array (that shows every "row")
 }
 
@@ -50,173 +55,174 @@ void show(char **array, int N)
 
 
 
-/*The side cells evolve - move to next generation*/
-void evolve_sides(char **old_gen, char **new_gen, char **border, int N, int thread_count, int *allzeros, int *change)
+/*Write the cells in a file that other programs read (e.g. gol-verify): the side and the generations computed in the first line,*/
+/*then "row column state" for every cell that is not dead, row by row*/
+void dump(char **cells, int N, int generations, const char *filename)
 {
-	int i, j, neighbors;
-
-	/*Calculate the neighbors of cells in lines based on received_border array*/
-	#	pragma omp parallel num_threads(thread_count) \
-	default(none) shared(old_gen, new_gen, border, N, allzeros, change) private(j, neighbors)
+	int  i, j;
+	FILE *fp = fopen(filename, "w");
 
+	if (fp == NULL){
+		fprintf(stderr, "Cannot write the cells in %s\n", filename);
+		return;
+	}
+	fprintf(fp, "%d %d\n", N, generations);
+	for (i = 0; i < N; i++)
 		for (j = 0; j < N; j++)
-		{															//Up line
-			neighbors = 0;
-			if ((j == 0) && (border[4][0] == 1)) neighbors++;				//Upleft
-			else if ((j != 0) && (border[5][j-1] == 1)) neighbors++;
-			if (border[5][j] == 1) neighbors++;								//Up
-			if ((j == N-1) && (border[6][0] == 1)) neighbors++;				//Upright
-			else if ((j != N-1) && (border[5][j+1] == 1)) neighbors++;
-			if ((j == N-1) && (border[7][0] == 1)) neighbors++;				//Right
-			else if ((j != N-1) && (old_gen[0][j+1] == 1)) neighbors++;
-			if ((j == N-1) && (border[7][1] == 1)) neighbors++;				//Downright
-			else if ((j != N-1) && (old_gen[1][j+1] == 1)) neighbors++;
-			if (old_gen[1][j] == 1) neighbors++;							//Down
-			if ((j == 0) && (border[3][1] == 1)) neighbors++;				//Downleft
-			else if ((j != 0) && (old_gen[1][j-1] == 1)) neighbors++;
-			if ((j == 0) && (border[3][0] == 1)) neighbors++;				//Left
-			else if ((j != 0) && (old_gen[0][j-1] == 1)) neighbors++;
-			/*--------------------------------------------------------------------------*/
-			if ((old_gen[0][j] == 1) && ((neighbors < 2) || (neighbors > 3)))
-				new_gen[0][j] = 0;
-			else if ((old_gen[0][j] == 0) && (neighbors == 3))
-				new_gen[0][j] = 1;
-			else
-				new_gen[0][j] = old_gen[0][j];		//Assign new values in up line's cells (if alive or dead)
-
-			if (new_gen[0][j] != 0) *allzeros = 1;
-			if (new_gen[0][j] != old_gen[0][j]) *change = 1;
-
-																	//Down line
-			neighbors = 0;
-			if ((j == 0) && (border[3][N-2] == 1)) neighbors++;				//Upleft
-			else if ((j != 0) && (old_gen[N-2][j-1] == 1)) neighbors++;
-			if (old_gen[N-2][j] == 1) neighbors++;							//Up
-			if ((j == N-1) && (border[7][N-2] == 1)) neighbors++;			//Upright
-			else if ((j != N-1) && (old_gen[N-2][j+1] == 1)) neighbors++;
-			if ((j == N-1) && (border[7][0] == 1)) neighbors++;				//Right
-			else if ((j != N-1) && (old_gen[N-1][j+1] == 1)) neighbors++;
-			if ((j == N-1) && (border[0][0] == 1)) neighbors++;				//Downright
-			else if ((j != N-1) && (border[1][j+1] == 1)) neighbors++;
-			if (border[1][j] == 1) neighbors++;								//Down
-			if ((j == 0) && (border[2][0] == 1)) neighbors++;				//Downleft
-			else if ((j != 0) && (border[1][j-1] == 1)) neighbors++;
-			if ((j == 0) && (border[3][0] == 1)) neighbors++;				//Left
-			else if ((j != 0) && (old_gen[N-1][j-1] == 1)) neighbors++;
-			/*--------------------------------------------------------------------------*/
-			if ((old_gen[N-1][j] == 1) && ((neighbors < 2) || (neighbors > 3)))
-				new_gen[N-1][j] = 0;
-			else if ((old_gen[N-1][j] == 0) && (neighbors == 3))
-				new_gen[N-1][j] = 1;
-			else
-				new_gen[N-1][j] = old_gen[N-1][j];		//Assign new values in down line's cells (if alive or dead)
-
-			if (new_gen[N-1][j] != 0) *allzeros = 1;
-			if (new_gen[N-1][j] != old_gen[N-1][j]) *change = 1;
-		}
+			if (cells[i][j] != 0) fprintf(fp, "%d %d %d\n", i, j, cells[i][j]);
+	fclose(fp);
+}
+
+
+
+/*Add the statistics of the cells a thread computed to the ones of the block (the bounding boxes are joined)*/
+static void joinStats(gol_stats *block, const gol_stats *part)
+{
+	#	pragma omp critical (stats)
+	{
+		block->population += part->population;
+		block->births     += part->births;
+		block->deaths     += part->deaths;
+		if (part->top < block->top) block->top = part->top;
+		if (part->left < block->left) block->left = part->left;
+		if (part->bottom > block->bottom) block->bottom = part->bottom;
+		if (part->right > block->right) block->right = part->right;
+	}
+}
+
+
+
+/*The side cells evolve - move to next generation, the block is padded with the ghost frame of the neighbours' cells (received*/
+/*straight in it), so the threads share the rows of the sides and compute them with the kernel of libgol, without any branches.*/
+/*If stats is not NULL, every thread also counts its cells in the same sweep and adds them to it in the end*/
+void evolve_sides(char **old_gen, char **new_gen, int N, char rule[2][9], int thread_count, int *allzeros, int *change, gol_stats *stats)
+{
+	int alive = 0, changed = 0;
 
-	/*Calculate the neighbors of cells in rows based on received_border array*/
 	#	pragma omp parallel num_threads(thread_count) \
-	default(none) shared(old_gen, new_gen, border, N, allzeros, change) private(i, neighbors)
-
-		for (i = 0; i < N; i++)
-		{															//Left line
-			neighbors = 0;
-			if ((i == 0) && (border[4][0] == 1)) neighbors++;				//Upleft
-			else if ((i != 0) && (border[3][i-1] == 1)) neighbors++;
-			if ((i == 0) && (border[5][0] == 1)) neighbors++;				//Up
-			else if ((i != 0) && (old_gen[i-1][0] == 1)) neighbors++;
-			if ((i == 0) && (border[5][1] == 1)) neighbors++;				//Upright
-			else if ((i != 0) && (old_gen[i-1][1] == 1)) neighbors++;
-			if (old_gen[i][1] == 1) neighbors++;							//Right
-			if ((i == N-1) && (border[1][1] == 1)) neighbors++;				//Downright
-			else if ((i != N-1) && (old_gen[i+1][1] == 1)) neighbors++;
-			if ((i == N-1) && (border[1][0] == 1)) neighbors++;				//Down
-			else if ((i != N-1) && (old_gen[i+1][0] == 1)) neighbors++;
-			if ((i == N-1) && (border[2][0] == 1)) neighbors++;				//Downleft
-			else if ((i != N-1) && (border[3][i+1] == 1)) neighbors++;
-			if (border[3][i] == 1) neighbors++;								//Left
-			/*--------------------------------------------------------------------------*/
-			if ((old_gen[i][0] == 1) && ((neighbors < 2) || (neighbors > 3)))
-				new_gen[i][0] = 0;
-			else if ((old_gen[i][0] == 0) && (neighbors == 3))
-				new_gen[i][0] = 1;
-			else
-				new_gen[i][0] = old_gen[i][0];		//Assign new values in left row's cells (if alive or dead)
-
-			if (new_gen[i][0] != 0) *allzeros = 1;
-			if (new_gen[i][0] != old_gen[i][0]) *change = 1;
-
-																	//Right line
-			neighbors = 0;
-			if ((i == 0) && (border[5][N-2] == 1)) neighbors++;				//Upleft
-			else if ((i != 0) && (old_gen[i-1][N-2] == 1)) neighbors++;
-			if ((i == 0) && (border[5][N-1] == 1)) neighbors++;				//Up
-			else if ((i != 0) && (old_gen[i-1][N-1] == 1)) neighbors++;
-			if ((i == 0) && (border[6][0] == 1)) neighbors++;				//Upright
-			else if ((i != 0) && (border[7][i-1] == 1)) neighbors++;
-			if (border[7][i] == 1) neighbors++;								//Right
-			if ((i == N-1) && (border[0][0] == 1)) neighbors++;				//Downright
-			else if ((i != N-1) && (border[7][i+1] == 1)) neighbors++;
-			if ((i == N-1) && (border[1][N-1] == 1)) neighbors++;			//Down
-			else if ((i != N-1) && (old_gen[i+1][N-1] == 1)) neighbors++;
-			if ((i == N-1) && (border[1][N-2] == 1)) neighbors++;			//Downleft
-			else if ((i != N-1) && (old_gen[i+1][N-2] == 1)) neighbors++;
-			if (old_gen[i][N-2] == 1) neighbors++;							//Left
-			/*--------------------------------------------------------------------------*/
-			if ((old_gen[i][N-1] == 1) && ((neighbors < 2) || (neighbors > 3)))
-				new_gen[i][N-1] = 0;
-			else if ((old_gen[i][N-1] == 0) && (neighbors == 3))
-				new_gen[i][N-1] = 1;
-			else
-				new_gen[i][N-1] = old_gen[i][N-1];		//Assign new values in right row's cells (if alive or dead)
-
-			if (new_gen[i][N-1] != 0) *allzeros = 1;
-			if (new_gen[i][N-1] != old_gen[i][N-1]) *change = 1;
-		}
+	default(none) shared(old_gen, new_gen, N, rule, stats) reduction(|: alive, changed)
+	{
+		int i;
+		gol_stats mine, *part = (stats != NULL) ? &mine : NULL;
+
+		if (part != NULL) gol_stats_clear(part);
+		#	pragma omp for schedule(static)
+			for (i = 1; i <= N; i++){
+				if ((i == 1) || (i == N))										//Up and down line, whole
+					gol_evolve_stats(&(old_gen[0][0]), &(new_gen[0][0]), N+2, i, i+1, 1, N+1, rule, &alive, &changed, part);
+				else {															//Left and right cell of the other rows
+					gol_evolve_stats(&(old_gen[0][0]), &(new_gen[0][0]), N+2, i, i+1, 1, 2, rule, &alive, &changed, part);
+					gol_evolve_stats(&(old_gen[0][0]), &(new_gen[0][0]), N+2, i, i+1, N, N+1, rule, &alive, &changed, part);
+				}
+			}
+		if (part != NULL) joinStats(stats, part);
+	}
+
+	if (alive) *allzeros = 1;
+	if (changed) *change = 1;
 }
 
 
 
-/*The inner cells evolve (not the side ones)*/
-void evolve_inner(char **old_gen, char **new_gen, int N, int thread_count, int *allzeros, int *change)
+/*The inner cells evolve (not the side ones) of a padded block, the threads share the rows and compute them with the kernel of libgol*/
+/*(and count them in stats, as evolve_sides())*/
+void evolve_inner(char **old_gen, char **new_gen, int N, char rule[2][9], int thread_count, int *allzeros, int *change, gol_stats *stats)
 {
-	int i, j, up, down, left, right, neighbors;
+	int alive = 0, changed = 0;
 
-	/*Calculate the "inside" cells, from (1,1) till (N-1,N-1)*/
 	#	pragma omp parallel num_threads(thread_count) \
-	default(none) shared(old_gen, new_gen, N, allzeros, change) private(i, j, up, down, left, right, neighbors)
-
-		for (i = 1; i < N-1; i++)
-		{										//Calculate up and down rows
-			up   = i-1;
-			down = i+1;
-
-			#	pragma omp for
-			for (j = 1; j < N-1; j++)
-			{									//Calculate left and right columns
-				left  = j-1;
-				right = j+1;
-				neighbors = 0;
-
-				if (old_gen[up][left]    == 1) neighbors++;				//Check the neighbors
-				if (old_gen[up][j]       == 1) neighbors++;
-				if (old_gen[up][right]   == 1) neighbors++;
-				if (old_gen[i][right]    == 1) neighbors++;
-				if (old_gen[down][right] == 1) neighbors++;
-				if (old_gen[down][j]     == 1) neighbors++;
-				if (old_gen[down][left]  == 1) neighbors++;
-				if (old_gen[i][left]     == 1) neighbors++;
-
-				if ((old_gen[i][j] == 1) && ((neighbors < 2) || (neighbors > 3)))
-					new_gen[i][j] = 0;
-				else if ((old_gen[i][j] == 0) && (neighbors == 3))
-					new_gen[i][j] = 1;
-				else
-					new_gen[i][j] = old_gen[i][j];		//Assign new values in "inside" cells (if alive or dead)
-
-				if (new_gen[i][j] != 0) *allzeros = 1;
-				if (new_gen[i][j] != old_gen[i][j]) *change = 1;
+	default(none) shared(old_gen, new_gen, N, rule, stats) reduction(|: alive, changed)
+	{
+		int i;
+		gol_stats mine, *part = (stats != NULL) ? &mine : NULL;
+
+		if (part != NULL) gol_stats_clear(part);
+		#	pragma omp for schedule(static)
+			for (i = 2; i < N; i++)
+				gol_evolve_stats(&(old_gen[0][0]), &(new_gen[0][0]), N+2, i, i+1, 2, N, rule, &alive, &changed, part);
+		if (part != NULL) joinStats(stats, part);
+	}
+
+	if (alive) *allzeros = 1;
+	if (changed) *change = 1;
+}
+
+
+
+/*Build the table of the 4x4 -> 2x2 kernel (64 KiB): bit 4*r+c of the index is the cell (r, c) of a 4x4 square and the entry holds*/
+/*the next values of its 4 centre cells, bit 0 for (1,1), bit 1 for (1,2), bit 2 for (2,1) and bit 3 for (2,2)*/
+unsigned char *buildLookup(char rule[2][9])
+{
+	int  index, k, r, c, dr, dc, neighbours;
+	unsigned char *lut = malloc(LOOKUP_SIZE * sizeof(unsigned char));
+
+	for (index = 0; index < LOOKUP_SIZE; index++){
+		lut[index] = 0;
+		for (k = 0; k < 4; k++){
+			r = 1 + k/2;
+			c = 1 + k%2;
+			neighbours = 0;
+			for (dr = -1; dr <= 1; dr++)
+				for (dc = -1; dc <= 1; dc++)
+					if ((dr != 0) || (dc != 0)) neighbours += (index >> (4*(r+dr) + c+dc)) & 1;
+			if (rule[(index >> (4*r + c)) & 1][neighbours]) lut[index] |= 1 << k;
+		}
+	}
+	return lut;
+}
+
+
+
+/*The inner cells evolve as evolve_inner(), but 2x2 cells at a time with one lookup in the table of buildLookup(). Moving 2 columns*/
+/*right, the index keeps the last 2 cells of every row of the 4x4 square (a shift) and takes only the 8 new ones. If the inner cells*/
+/*are not an even number of rows or columns, the last one is computed with the kernel of libgol*/
+void evolve_inner_lut(char **old_gen, char **new_gen, int N, char rule[2][9], const unsigned char *lut, int thread_count, int *allzeros, int *change)
+{
+	int  i, j, even = (N-2) / 2 * 2, alive = 0, changed = 0;
+	unsigned int index, after;
+	const char *r0, *r1, *r2, *r3;
+
+	#	pragma omp parallel for num_threads(thread_count) schedule(static) \
+	default(none) shared(old_gen, new_gen, lut, even) private(j, index, after, r0, r1, r2, r3) reduction(|: alive, changed)
+		for (i = 2; i < 2+even; i += 2){
+			r0 = old_gen[i-1];
+			r1 = old_gen[i];
+			r2 = old_gen[i+1];
+			r3 = old_gen[i+2];
+			index = r0[1] | (r0[2] << 1) | (r1[1] << 4) | (r1[2] << 5) | (r2[1] << 8) | (r2[2] << 9) | (r3[1] << 12) | (r3[2] << 13);
+			for (j = 2; j < 2+even; j += 2){
+				index |= (r0[j+1] << 2)  | (r0[j+2] << 3)  | (r1[j+1] << 6)  | (r1[j+2] << 7)
+				       | (r2[j+1] << 10) | (r2[j+2] << 11) | (r3[j+1] << 14) | (r3[j+2] << 15);
+				after = lut[index];
+				new_gen[i][j]     = after & 1;
+				new_gen[i][j+1]   = (after >> 1) & 1;
+				new_gen[i+1][j]   = (after >> 2) & 1;
+				new_gen[i+1][j+1] = (after >> 3) & 1;
+				alive   |= after;
+				changed |= after ^ (((index >> 5) & 3) | ((index >> 7) & 12));		//The 2x2 centre before
+				index = (index >> 2) & 0x3333;									//Columns j+1 and j+2 are the first ones of the next square
 			}
 		}
+
+	gol_evolve(&(old_gen[0][0]), &(new_gen[0][0]), N+2, 2+even, N, 2, N, rule, &alive, &changed);			//Last row (odd number of rows)
+	gol_evolve(&(old_gen[0][0]), &(new_gen[0][0]), N+2, 2, 2+even, 2+even, N, rule, &alive, &changed);		//Last column
+
+	if (alive) *allzeros = 1;
+	if (changed) *change = 1;
+}
+
+
+
+/*The groups of a batch evolve (from first to the last group every stride-th, one whole group of 64 boards per thread at a time)*/
+void evolve_batch(uint64_t *cells, int N, int boards, int first, int stride, int generations, char rule[2][9], int thread_count, int *ended, int *status, int *alive)
+{
+	int g, lanes, groups = (boards + BATCH_LANES - 1) / BATCH_LANES;
+
+	#	pragma omp parallel for num_threads(thread_count) schedule(dynamic) \
+	default(none) shared(cells, N, boards, first, stride, groups, generations, rule, ended, status, alive) private(lanes)
+		for (g = first; g < groups; g += stride)
+		{
+			lanes = (boards - g*BATCH_LANES < BATCH_LANES) ? boards - g*BATCH_LANES : BATCH_LANES;
+			evolve_group(cells + (size_t)g*N*N, N, lanes, generations, rule, &(ended[g*BATCH_LANES]), &(status[g*BATCH_LANES]), &(alive[g*BATCH_LANES]));
+		}
 }
\ No newline at end of file
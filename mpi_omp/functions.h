@@ -1,13 +1,21 @@
 #include <omp.h>
+#include <stdint.h>
+#include "gol.h"
 #ifndef __functions__
 #define __functions__
 
+#define LOOKUP_SIZE 65536			//Entries of the 4x4 -> 2x2 table (one for every 16 cells)
+
 
 char **allocateArray(int n, int init_flag);
 void deleteArray(char ***array);
 void show(char **cells, int N);
-void evolve_sides(char **old_gen, char **new_gen, char **border, int N, int thread_count, int *allzeros, int *change);
-void evolve_inner(char **old_gen, char **new_gen, int N, int thread_count, int *allzeros, int *change);
+void dump(char **cells, int N, int generations, const char *filename);
+void evolve_sides(char **old_gen, char **new_gen, int N, char rule[2][9], int thread_count, int *allzeros, int *change, gol_stats *stats);
+void evolve_inner(char **old_gen, char **new_gen, int N, char rule[2][9], int thread_count, int *allzeros, int *change, gol_stats *stats);
+unsigned char *buildLookup(char rule[2][9]);
+void evolve_inner_lut(char **old_gen, char **new_gen, int N, char rule[2][9], const unsigned char *lut, int thread_count, int *allzeros, int *change);
+void evolve_batch(uint64_t *cells, int N, int boards, int first, int stride, int generations, char rule[2][9], int thread_count, int *ended, int *status, int *alive);
 
 
 #endif
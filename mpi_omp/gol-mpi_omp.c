@@ -5,6 +5,12 @@
 #include <math.h>
 #include "mpi.h"
 #include "functions.h"
+#include "halo.h"
+#include "gol.h"
+#include "batch.h"
+#include "trace.h"
+#include "memory.h"
+#include "stats.h"
 
 
 #define BUFSIZE 64
@@ -16,8 +22,11 @@ int main(int argc, char *argv[])
 {
 	int  i, j, N, SideBlocks, SideProcesses, generations;
 	int  processes, my_rank, output = 0, doom = 0, thread_count = 2;
-	int  nozero, diff, allzeros, change;
-	char **cells, **blocks;
+	int  nozero, diff, allzeros, change, boards = 0, groups, *ended, *endings, *alive;
+	unsigned int seed = time(NULL);
+	char **cells, **blocks, rule[2][9], *rulestring = "B3/S23", *tracefile = NULL, *dumpfile = NULL, *statsfile = NULL;
+	unsigned char *lut = NULL;
+	int  lookup = 0;
 	FILE *fp = NULL;
 
 
@@ -35,7 +44,90 @@ int main(int argc, char *argv[])
 		else if (!strcmp(argv[i], "-o1")) output = 1;
 		else if (!strcmp(argv[i], "-o2")) output = 2;
 		else if (!strcmp(argv[i], "-d")) doom = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-r")) rulestring = argv[++i];
+		else if (!strcmp(argv[i], "-T")) tracefile = argv[++i];
+		else if (!strcmp(argv[i], "-w")) dumpfile = argv[++i];
 		else if (!strcmp(argv[i], "-t")) thread_count = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-b")) boards = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-s")) seed = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-l")) lookup = 1;
+		else if (!strcmp(argv[i], "-S")) statsfile = argv[++i];
+	}
+
+	/*Build the transition table of the rule (Conway's B3/S23 by default), or else exit*/
+	if (gol_parse_rule(rulestring, rule) != 0){
+		if (my_rank == 0) fprintf(stderr, "Invalid rule %s (B/S notation is expected, e.g. B36/S23)\n", rulestring);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+
+	/*The statistics come from evolve_inner() and evolve_sides(), the lookup kernel and the batch keep none*/
+	if ((statsfile != NULL) && (lookup || (boards > 0))){
+		if (my_rank == 0) fprintf(stderr, "Statistics (-S) are kept only without the lookup kernel (-l) and the batch mode (-b)\n");
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+
+
+	/*Batch mode (-b) - many independent N x N boards, every process takes whole groups of 64 boards (one in every bit) and its threads share them*/
+	if (boards > 0)
+	{
+		groups = (boards + BATCH_LANES - 1) / BATCH_LANES;
+		uint64_t *batch = allocateGroups(groups, N);
+		ended  = calloc(groups*BATCH_LANES, sizeof(int));
+		endings = calloc(groups*BATCH_LANES, sizeof(int));
+		alive  = calloc(groups*BATCH_LANES, sizeof(int));
+
+		/*Every process builds all the boards (the same ones, so the seed of the main process is used) and evolves only its own groups*/
+		if (fp == NULL){
+			MPI_Bcast(&seed, 1, MPI_UNSIGNED, 0, MPI_COMM_WORLD);
+			srand(seed);
+			randomBatch(batch, N, boards);
+		}
+		else {
+			if (readBatch(fp, batch, N, boards) != 0){
+				if (my_rank == 0) fprintf(stderr, "Invalid input file (lines \"board row column\" with up to %d boards of %d x %d cells are expected)\n", boards, N, N);
+				MPI_Abort(MPI_COMM_WORLD, 1);
+			}
+			fclose(fp);
+		}
+
+		double start, finish, alltime, maxtime, mintime, sumtime;
+		MPI_Barrier(MPI_COMM_WORLD);
+		start = MPI_Wtime();
+
+		evolve_batch(batch, N, boards, my_rank, processes, generations, rule, thread_count, ended, endings, alive);
+
+		/*The results of the groups of other processes are 0s, so summing them gathers all the boards in the main process*/
+		int *all = (my_rank == 0) ? malloc(3*boards * sizeof(int)) : NULL;
+		MPI_Reduce(ended, all, boards, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+		MPI_Reduce(endings, (my_rank == 0) ? all+boards : NULL, boards, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+		MPI_Reduce(alive, (my_rank == 0) ? all+2*boards : NULL, boards, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+		if (my_rank == 0){
+			showBatch(boards, all, all+boards, all+2*boards, output);		//How every board ended is printed only if told so in command line (-o1)
+			free(all);
+		}
+
+		deleteGroups(batch);
+		free(ended);
+		free(endings);
+		free(alive);
+
+		finish = MPI_Wtime();
+		alltime = finish - start;
+		MPI_Reduce(&alltime, &maxtime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+		MPI_Reduce(&alltime, &mintime, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
+		MPI_Reduce(&alltime, &sumtime, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+		if (my_rank == 0){
+			printf("\n///////////////////////////////////////////////////\n\n");
+			printf("--------------------------------------------------------------\n");
+			printf("Maximum Runtime = %f\n", maxtime);
+			printf("Minimum Runtime = %f\n", mintime);
+			printf("Average Runtime = %f\n", sumtime/processes);
+			printf("--------------------------------------------------------------\n");
+		}
+
+		emptyPool();
+		MPI_Finalize();
+		return 0;
 	}
 
 
@@ -74,14 +166,15 @@ int main(int argc, char *argv[])
 	}
 
 	/*Start timer - finish just before MPI_Finalize()*/
-	double start, finish;
+	double start, finish, t = 0.0;
 	MPI_Barrier(MPI_COMM_WORLD);
 	start = MPI_Wtime();
+	if (tracefile != NULL) traceStart(tracefile, generations, start);		//Time every phase of every generation (-T in cmd)
 
 	/*Allocate memory for blocks in every process*/
 	SideProcesses = (int) sqrt((float)processes);
 	SideBlocks = (int) (N / SideProcesses);
-	blocks = allocateArray(SideBlocks, 0);
+	blocks = allocateArray(SideBlocks+2, 0);			//A ghost frame one cell wide surrounds each block
 
 
 	/*Create a datatype for the subarrays (blocks) of the global cells array*/
@@ -93,6 +186,13 @@ int main(int argc, char *argv[])
 	MPI_Type_create_resized(type, 0, SideBlocks*sizeof(char), &subarraytype);				//Extend the above type
 	MPI_Type_commit(&subarraytype);															//Commit the subarray datatype
 
+	/*Only the interior of the blocks is scattered and gathered, without their ghost frame*/
+	int blocksizes[2]  = {SideBlocks+2, SideBlocks+2};
+	int blockstarts[2] = {1, 1};
+	MPI_Datatype blocktype;
+	MPI_Type_create_subarray(2, blocksizes, subsizes, blockstarts, MPI_ORDER_C, MPI_CHAR, &blocktype);
+	MPI_Type_commit(&blocktype);
+
 	/*Scatter the array to all processors*/
 	int counts[processes], starting_point[processes], displacement;
 	if (my_rank == 0){
@@ -107,7 +207,7 @@ int main(int argc, char *argv[])
 			displacement += (SideBlocks-1)*SideProcesses;				//Each starting point is at every block extend
 		}
 	}
-	MPI_Scatterv(&(cells[0][0]), counts, starting_point, subarraytype, &(blocks[0][0]), N*N/processes, MPI_CHAR, 0, MPI_COMM_WORLD);
+	MPI_Scatterv(&(cells[0][0]), counts, starting_point, subarraytype, &(blocks[0][0]), 1, blocktype, 0, MPI_COMM_WORLD);
 
 
 	/*The subarrays must arranged as Cartesian coordinate structure for proper communication between the local ones*/
@@ -146,69 +246,72 @@ int main(int argc, char *argv[])
 	neighbor[0] = coords[0];
 	neighbor[1] = coords[1] - 1;
 	MPI_Cart_rank(new_comm, neighbor, &left);				//Left
+	int neighbors[8] = {upleft, up, upright, right, downright, down, downleft, left};
 
 
-	/*Declare waitall() variables and arrays for copy a line or cell (neighbor_border) and receive (received_border)*/
-	MPI_Request request[8];
-	MPI_Status  status[8];
-	char *neighbor_border, side_border[SideBlocks], **received_border, *help1, **help2;
-	neighbor_border = malloc(SideBlocks * sizeof(char));
-	help1 = neighbor_border;											//Copy array - neighbor_border
-	received_border = malloc(8 * sizeof(char*));
-	for (i = 0; i < 8; i++)												//Paste (receive) array - received_border
-		received_border[i] = malloc(SideBlocks * sizeof(char));
-	help2 = received_border;
+	/*Declare waitall() variables for the 8 sends and the 8 receives of the ghost frame, and the datatypes of its sides and corners*/
+	MPI_Request request[16];
+	MPI_Status  status[16];
+	MPI_Datatype halotypes[3];
+	createHaloTypes(SideBlocks, 1, halotypes);
 
 	/*A temporary array to find the new values of cells for the next generation and then copy it to blocks array*/
 	char **new_gen, **swap;
-	new_gen = allocateArray(SideBlocks, 0);
+	new_gen = allocateArray(SideBlocks+2, 0);
+
+	/*The table of the inner cells kernel that computes 2x2 cells with one lookup (-l in cmd)*/
+	if (lookup) lut = buildLookup(rule);
+
+	/*Population, births, deaths and bounding box of every generation, counted by the kernels in each block (-S in cmd)*/
+	gol_stats blockstats, *stats = NULL;
+	int  row0 = (my_rank / SideProcesses) * SideBlocks - 1, col0 = (my_rank % SideProcesses) * SideBlocks - 1;		//Board place of blocks[0][0]
+	if (statsfile != NULL){
+		if (statsStart(statsfile, my_rank, MPI_COMM_WORLD) != 0){
+			fprintf(stderr, "Cannot write the statistics in %s\n", statsfile);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+		stats = &blockstats;
+	}
 
 
+	/*The ghost frame of the first generation is posted before the loop, then in every generation the side cells are computed first*/
+	/*and their new values are sent for the next one, so that the messages travel while the inner cells evolve*/
+	if (generations > 1) exchangeHalo(blocks, SideBlocks, 1, neighbors, halotypes, MPI_COMM_WORLD, request);
+
 	/*All generations are sychronized and each output is shown by the master process*/
 	for (i = 0; i < generations; i++)
 	{
-		if ((my_rank == 0) && (output == 2))
-			show(cells, N);						//Print the cells array as modified in this generation (-o2 in cmd)
+		TRACE_MARK(t);
+		if (output == 2){
+			if (my_rank == 0) show(cells, N);	//Print the cells array as modified in this generation (-o2 in cmd)
+			TRACE_PHASE(TRACE_OUTPUT, i, t);
+		}
 
 		if (i != generations-1)
 		{
-			/*Send the border 1D (line) arrays to the proper neighbor, who receives this neighboring line or cell*/
-			neighbor_border = &(blocks[0][0]);
-			MPI_Isend(neighbor_border, 1, MPI_CHAR, upleft, 0, MPI_COMM_WORLD, &request[0]);
-			MPI_Irecv(received_border[0], 1, MPI_CHAR, downright, 0, MPI_COMM_WORLD, &request[1]);			// 0 - downright cell
-			neighbor_border = &(blocks[0][0]);
-			MPI_Isend(neighbor_border, SideBlocks, MPI_CHAR, up, 0, MPI_COMM_WORLD, &request[2]);
-			MPI_Irecv(received_border[1], SideBlocks, MPI_CHAR, down, 0, MPI_COMM_WORLD, &request[3]);		// 1 - down side
-			neighbor_border = &(blocks[0][SideBlocks-1]);
-			MPI_Isend(neighbor_border, 1, MPI_CHAR, upright, 0, MPI_COMM_WORLD, &request[4]);
-			MPI_Irecv(received_border[2], 1, MPI_CHAR, downleft, 0, MPI_COMM_WORLD, &request[5]);			// 2 - downleft cell
-			for (j = 0; j < SideBlocks; j++)
-				side_border[j] = blocks[j][SideBlocks-1];
-			MPI_Isend(side_border, SideBlocks, MPI_CHAR, right, 0, MPI_COMM_WORLD, &request[6]);
-			MPI_Irecv(received_border[3], SideBlocks, MPI_CHAR, left, 0, MPI_COMM_WORLD, &request[7]);		// 3 - left side
-			neighbor_border = &(blocks[SideBlocks-1][SideBlocks-1]);
-			MPI_Isend(neighbor_border, 1, MPI_CHAR, downright, 0, MPI_COMM_WORLD, &request[8]);
-			MPI_Irecv(received_border[4], 1, MPI_CHAR, upleft, 0, MPI_COMM_WORLD, &request[9]);				// 4 - upleft cell
-			neighbor_border = &(blocks[SideBlocks-1][0]);
-			MPI_Isend(neighbor_border, SideBlocks, MPI_CHAR, down, 0, MPI_COMM_WORLD, &request[10]);
-			MPI_Irecv(received_border[5], SideBlocks, MPI_CHAR, up, 0, MPI_COMM_WORLD, &request[11]);		// 5 - up side
-			neighbor_border = &(blocks[SideBlocks-1][0]);
-			MPI_Isend(neighbor_border, 1, MPI_CHAR, downleft, 0, MPI_COMM_WORLD, &request[12]);
-			MPI_Irecv(received_border[6], 1, MPI_CHAR, upright, 0, MPI_COMM_WORLD, &request[13]);			// 6 - upright cell
-			for (j = 0; j < SideBlocks; j++)
-				side_border[j] = blocks[j][0];
-			MPI_Isend(side_border, SideBlocks, MPI_CHAR, left, 0, MPI_COMM_WORLD, &request[14]);
-			MPI_Irecv(received_border[7], SideBlocks, MPI_CHAR, right, 0, MPI_COMM_WORLD, &request[15]);	// 7 - right side
-
 			allzeros = 0;				//Check if there are all 0s (at least one 1, then evolve function returns 1 in allzeros variable)
 			change   = 0;				//Check if the new generation is similar to the previous one (if not change is returned as 1)
+			if (statistics) gol_stats_clear(&blockstats);
+
+			MPI_Waitall(16, request, status);	//The ghost frame of this generation (posted in the previous one) is in
+			TRACE_PHASE(TRACE_WAIT, i, t);
 
-			evolve_inner(blocks, new_gen, SideBlocks, thread_count, &allzeros, &change);	//Until send-receive is done, compute the inner cells
+			evolve_sides(blocks, new_gen, SideBlocks, rule, thread_count, &allzeros, &change, stats);		//Evolve the side cells of blocks
+			TRACE_PHASE(TRACE_SIDES, i, t);
 
-			MPI_Waitall(8, request, status);
-			MPI_Barrier(MPI_COMM_WORLD);			//Wait for all processes to send and receive the neighboring cells
+			/*The new sides leave at once for the next generation (straight in the ghost frame of new_gen) while the inner cells evolve*/
+			if (i+1 != generations-1) exchangeHalo(new_gen, SideBlocks, 1, neighbors, halotypes, MPI_COMM_WORLD, request);
+			TRACE_PHASE(TRACE_HALO, i, t);
 
-			evolve_sides(blocks, new_gen, received_border, SideBlocks, thread_count, &allzeros, &change);		//Evolve the side cells of blocks
+			if (lookup) evolve_inner_lut(blocks, new_gen, SideBlocks, rule, lut, thread_count, &allzeros, &change);
+			else evolve_inner(blocks, new_gen, SideBlocks, rule, thread_count, &allzeros, &change, stats);
+			TRACE_PHASE(TRACE_INNER, i, t);
+
+			/*The statistics of the blocks are reduced in batches of generations, while the next ones evolve*/
+			if (statistics){
+				statsRecord(i+1, &blockstats, row0, col0);
+				TRACE_PHASE(TRACE_REDUCE, i, t);
+			}
 
 			/*Terminal checking (every 10 generations), if the array is still the same or is full of 0s, then stop the program*/
 			if ((doom == 1) && ((i % 10) == 0) && (i != 0)){
@@ -218,6 +321,7 @@ int main(int argc, char *argv[])
 					fprintf(stderr, "Program terminated (nothing changed or all extinguisted in this generation)\n");
 					MPI_Abort(MPI_COMM_WORLD, 1);
 				}
+				TRACE_PHASE(TRACE_REDUCE, i, t);
 			}
 
 			swap    = blocks;
@@ -225,28 +329,34 @@ int main(int argc, char *argv[])
 			new_gen = swap;
 
 			/*After each generation, gather all the blocks (with their new values) into the initial cells array (-o2 in cmd)*/
-			if (output == 2)
-				MPI_Gatherv(&(blocks[0][0]), N*N/processes, MPI_CHAR, &(cells[0][0]), counts, starting_point, subarraytype, 0, MPI_COMM_WORLD);
+			if (output == 2){
+				MPI_Gatherv(&(blocks[0][0]), 1, blocktype, &(cells[0][0]), counts, starting_point, subarraytype, 0, MPI_COMM_WORLD);
+				TRACE_PHASE(TRACE_OUTPUT, i, t);
+			}
 		}
 	}
-	/*After all processes are done, gather the blocks with their new values into the initial cells array (Whether there is output or not)*/
-	MPI_Gatherv(&(blocks[0][0]), N*N/processes, MPI_CHAR, &(cells[0][0]), counts, starting_point, subarraytype, 0, MPI_COMM_WORLD);
+	statsFinish();						//Reduce and write the statistics of the last generations
 
+	/*After all processes are done, gather the blocks with their new values into the initial cells array (Whether there is output or not)*/
+	TRACE_MARK(t);
+	MPI_Gatherv(&(blocks[0][0]), 1, blocktype, &(cells[0][0]), counts, starting_point, subarraytype, 0, MPI_COMM_WORLD);
+	TRACE_PHASE(TRACE_OUTPUT, generations-1, t);
 
-	for (i = 0; i < 8; i++)
-		free(help2[i]);					//Delete received_border 2D array (for receiving side cells depending on topology)
-	free(help2);
-	free(help1);						//Delete neighbor_border array (for copying side cells)
 
 	if (my_rank == 0){
 		if (output == 1)
 			show(cells, N);				//If told from command line, print the array (-o1 in cmd)
+		if (dumpfile != NULL)
+			dump(cells, N, (generations > 0) ? generations-1 : 0, dumpfile);		//Write the final cells in a file (-w in cmd)
 		deleteArray(&cells);			//Delete cells array
 	}
 	deleteArray(&blocks);				//Delete blocks array on each process
 	deleteArray(&new_gen);				//Delete the temporary array for copying new values
+	free(lut);
 
 	MPI_Type_free(&subarraytype);		//Free the subarray type
+	MPI_Type_free(&blocktype);			//Free the block interior and ghost frame types
+	freeHaloTypes(halotypes);
 
 
 	/*Stop timer and calculate the whole time of mpi procedures (generally the program time)*/
@@ -266,7 +376,9 @@ int main(int argc, char *argv[])
 		printf("Average Runtime = %f\n", sumtime/processes);
 		printf("--------------------------------------------------------------\n");
 	}
+	traceFinish(MPI_COMM_WORLD, my_rank, processes);		//Write the trace and the time of each phase (-T in cmd)
 
+	emptyPool();						//Return the buffers of the pool to the system
 	MPI_Finalize();						//End the MPI procedure
 
 	return 0;
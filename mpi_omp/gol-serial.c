@@ -2,48 +2,22 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include "gol.h"
+#include "batch.h"
+#include "memory.h"
 
 
 
-/*Allocate memory for a 2D array and initialize it*/
-char **allocateArray(int n, int init_flag)
+/*Print the cells of a board in command line*/
+void show(gol_board *board)
 {
-	char **array;
 	int  i, j;
-
-	array = malloc(n * sizeof(char*));
-	for (i = 0; i < n; i++){
-		array[i] = malloc(n * sizeof(char));
-		for (j = 0; j < n; j++){
-			if (init_flag == 0) array[i][j] = 0;			//Initialize the array items as 0s
-			else array[i][j] = rand() % 2;
-		}
-	}
-	return array;
-}
-
-
-
-/*Delete a 2D array which has dynamically allocated*/
-void deleteArray(char **array, int n)
-{
-	int i;
-	for (i = 0; i < n; i++)
-		free(array[i]);
-	free(array);
-}
-
-
-
-/*Print the cells in command line*/
-void show(char **cells, int N)
-{
-	int i, j;
+	char *cells = gol_cells(board);
 	printf("\n///////////////////////////////////////////////////\n\n");
-	for (i = 0; i < N; i++){
-		for (j = 0; j < N; j++){
-			if (cells[i][j] == 0) printf("-");
-			else if (cells[i][j] == 1) printf("X");
+	for (i = 0; i < gol_rows(board); i++){
+		for (j = 0; j < gol_cols(board); j++){
+			if (cells[i*gol_stride(board) + j] == 0) printf("-");
+			else if (cells[i*gol_stride(board) + j] == 1) printf("X");
 			else printf("?");
 		}
 		printf("\n");
@@ -52,29 +26,23 @@ void show(char **cells, int N)
 
 
 
-/*The cells evolve - move to next generation*/
-void evolve(char **old_gen, char **new_gen, int N)
+/*Write the cells in a file that other programs read (e.g. gol-verify): the side and the generations computed in the first line,*/
+/*then "row column state" for every cell that is not dead, row by row*/
+void dump(gol_board *board, int generations, const char *filename)
 {
-	int i, j, ul, u, ur, l, r, dl, d, dr, neighbors;
+	int  i, j;
+	char *cells = gol_cells(board);
+	FILE *fp = fopen(filename, "w");
 
-	for (i = 0; i < N; i++)
-	{
-		for (j = 0; j < N; j++)
-		{
-			ul = old_gen[((i-1)+N)%N][((j-1)+N)%N]; 
-			u  = old_gen[((i-1)+N)%N][((j)+N)%N];
-			ur = old_gen[((i-1)+N)%N][((j+1)+N)%N];
-			l  = old_gen[((i)+N)%N][((j-1)+N)%N];
-			r  = old_gen[((i)+N)%N][((j+1)+N)%N];
-			dl = old_gen[((i+1)+N)%N][((j-1)+N)%N];
-			d  = old_gen[((i+1)+N)%N][((j)+N)%N];
-			dr = old_gen[((i+1)+N)%N][((j+1)+N)%N];
-			neighbors = u + ur + ul + l + r + dr + dl + d;
-
-			char cell     = old_gen[i][j];
-			new_gen[i][j] = neighbors == 3 || (neighbors == 2 && cell);
-		}
+	if (fp == NULL){
+		fprintf(stderr, "Cannot write the cells in %s\n", filename);
+		return;
 	}
+	fprintf(fp, "%d %d\n", gol_rows(board), generations);
+	for (i = 0; i < gol_rows(board); i++)
+		for (j = 0; j < gol_cols(board); j++)
+			if (cells[i*gol_stride(board) + j] != 0) fprintf(fp, "%d %d %d\n", i, j, cells[i*gol_stride(board) + j]);
+	fclose(fp);
 }
 
 
@@ -82,9 +50,12 @@ void evolve(char **old_gen, char **new_gen, int N)
 /*Main program*/
 int main(int argc, char const *argv[])
 {
-	int  i, j, q, N, generations;
+	int  i, j, q, N, generations, boards = 0, groups, lanes, *ended, *status, *alive;
+	unsigned int seed = time(NULL);
+	uint64_t *batch;
 	char output = 0;
-	char **cells, **new_gen, **swap;
+	char *cells, rule[2][9], *rulestring = "B3/S23", *dumpfile = NULL;
+	gol_board *board;
 	char line[64], *token, delim[2] = " ";
 	FILE *fp = NULL;
 
@@ -95,15 +66,70 @@ int main(int argc, char const *argv[])
 		else if (!strcmp(argv[i], "-i")) fp = fopen(argv[++i], "r");
 		else if (!strcmp(argv[i], "-o1")) output = 1;
 		else if (!strcmp(argv[i], "-o2")) output = 2;
+		else if (!strcmp(argv[i], "-r")) rulestring = (char *)argv[++i];
+		else if (!strcmp(argv[i], "-b")) boards = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-s")) seed = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-w")) dumpfile = (char *)argv[++i];
 	}
 
-	/*Allocate memory for cells and new_gen arrays and initialize them with 0s or randomly*/
+	/*Build the transition table of the rule (Conway's B3/S23 by default), or else exit*/
+	if (gol_parse_rule(rulestring, rule) != 0){
+		fprintf(stderr, "Invalid rule %s (B/S notation is expected, e.g. B36/S23)\n", rulestring);
+		return 1;
+	}
+
+	/*Batch mode (-b) - many independent N x N boards evolve together, 64 of them in every word, each one stops on its own*/
+	if (boards > 0){
+		groups = (boards + BATCH_LANES - 1) / BATCH_LANES;
+		batch  = allocateGroups(groups, N);
+		ended  = malloc(groups*BATCH_LANES * sizeof(int));
+		status = malloc(groups*BATCH_LANES * sizeof(int));
+		alive  = malloc(groups*BATCH_LANES * sizeof(int));
+		if (fp == NULL){
+			srand(seed);
+			randomBatch(batch, N, boards);
+		}
+		else {
+			if (readBatch(fp, batch, N, boards) != 0){
+				fprintf(stderr, "Invalid input file (lines \"board row column\" with up to %d boards of %d x %d cells are expected)\n", boards, N, N);
+				return 1;
+			}
+			fclose(fp);
+		}
+
+		clock_t start = clock();						//Begin counting time
+
+		for (i = 0; i < groups; i++){
+			lanes = (boards - i*BATCH_LANES < BATCH_LANES) ? boards - i*BATCH_LANES : BATCH_LANES;
+			evolve_group(batch + (size_t)i*N*N, N, lanes, generations, rule, &(ended[i*BATCH_LANES]), &(status[i*BATCH_LANES]), &(alive[i*BATCH_LANES]));
+		}
+		showBatch(boards, ended, status, alive, output);		//How every board ended is printed only if told so in command line (-o1)
+
+		deleteGroups(batch);
+		emptyPool();
+		free(ended);
+		free(status);
+		free(alive);
+
+		/*Finish counting time, print it*/
+		clock_t finish = clock();
+		double alltime = (double)(finish - start) / CLOCKS_PER_SEC;
+		printf("\n///////////////////////////////////////////////////\n\n");
+		printf("--------------------------------------------------------------\n");
+		printf("Runtime %f \n", alltime);
+		printf("--------------------------------------------------------------\n");
+		return 0;
+	}
+
+	/*Create the board (libgol keeps the current and the next generation) and initialize it with 0s or randomly*/
+	board = gol_create(N, N, rulestring);
+	cells = gol_cells(board);
 	if (fp == NULL){
 		srand(time(NULL));
-		cells = allocateArray(N, 1);
+		for (i = 0; i < N; i++)
+			for (j = 0; j < N; j++)
+				cells[i*gol_stride(board) + j] = rand() % 2;
 	}
-	else cells = allocateArray(N, 0);
-	new_gen = allocateArray(N, 0);
 
 	/*Read from input file the position of initial live cells (if there is input file)*/
 	if (fp != NULL){
@@ -113,7 +139,7 @@ int main(int argc, char const *argv[])
 			i = atoi(token);
 			token = strtok(NULL, delim);
 			j = atoi(token);
-			cells[i][j] = 1;
+			cells[i*gol_stride(board) + j] = 1;
 			fgets(line, 64, fp);
 		}
 		fclose(fp);
@@ -124,19 +150,14 @@ int main(int argc, char const *argv[])
 	/*Calculate every generation and print it*/
 	for (q = 0; q < generations; q++)
 	{
-		if (output == 2) show(cells, N);		//Print the cells array in every generation if told so in command line (-o2)
+		if (output == 2) show(board);			//Print the cells array in every generation if told so in command line (-o2)
 
-		if (q != generations-1){
-			evolve(cells, new_gen, N);
-			swap    = cells;
-			cells   = new_gen;
-			new_gen = swap;
-		}
+		if (q != generations-1) gol_step(board, 1);
 	}
-	if (output == 1) show(cells, N);			//Print the cells array only at the end (-o1)
+	if (output == 1) show(board);				//Print the cells array only at the end (-o1)
+	if (dumpfile != NULL) dump(board, (generations > 0) ? generations-1 : 0, dumpfile);		//Write them in a file (-w)
 
-	deleteArray(cells, N);
-	deleteArray(new_gen, N);
+	gol_destroy(board);
 
 	/*Finish counting time, print it*/
 	clock_t finish = clock();
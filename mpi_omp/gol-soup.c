@@ -0,0 +1,99 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mpi.h"
+#include "gol.h"
+#include "unbounded.h"
+#include "soup.h"
+
+
+
+/*Soup search MPI program - In command line (example): mpiexec -n 4 ./gol-soup -k 10000 -s 1 -t 2*/
+/*Every process (and every thread of it) runs its own soups to the end and splits their ash in objects, the census is gathered only once*/
+int main(int argc, char *argv[])
+{
+	int  i, processes, my_rank, thread_count = 2, generations = 10000, length, *lengths = NULL, *displacements = NULL;
+	long soups = 1000, objects, unstable, allobjects, allunstable;
+	unsigned int seed = time(NULL);
+	char rule[2][9], *rulestring = "B3/S23", *buffer, *allbuffers = NULL;
+
+
+	/*Initialize MPI to share the soups between different processors*/
+	MPI_Init(&argc, &argv);
+	MPI_Comm_size(MPI_COMM_WORLD, &processes);
+	MPI_Comm_rank(MPI_COMM_WORLD, &my_rank);
+
+
+	/*Read the arguments*/
+	for (i = 0; i < argc; i++){
+		if (!strcmp(argv[i], "-k")) soups = atol(argv[++i]);
+		else if (!strcmp(argv[i], "-g")) generations = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-s")) seed = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-r")) rulestring = argv[++i];
+		else if (!strcmp(argv[i], "-t")) thread_count = atoi(argv[++i]);
+	}
+
+	/*Build the transition table of the rule (Conway's B3/S23 by default), or else exit*/
+	if ((gol_parse_rule(rulestring, rule) != 0) || (checkUnboundedRule(rule) != 0)){
+		if (my_rank == 0) fprintf(stderr, "Invalid rule %s (B/S notation without B0 is expected, e.g. B36/S23)\n", rulestring);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+	MPI_Bcast(&seed, 1, MPI_UNSIGNED, 0, MPI_COMM_WORLD);		//The same soups, whatever the number of processes
+
+
+	/*Start timer - finish after the census is gathered*/
+	double start, finish, alltime;
+	MPI_Barrier(MPI_COMM_WORLD);
+	start = MPI_Wtime();
+
+	/*Soup k is searched by process k % processes*/
+	census *local = createCensus();
+	objects = searchSoups(seed, my_rank, soups, processes, generations, rule, thread_count, local, &unstable);
+
+
+	/*Gather the census of every process in the main one (as text, since the objects differ from process to process)*/
+	buffer = packCensus(local, &length);
+	if (my_rank == 0){
+		lengths       = malloc(processes * sizeof(int));
+		displacements = malloc(processes * sizeof(int));
+	}
+	MPI_Gather(&length, 1, MPI_INT, lengths, 1, MPI_INT, 0, MPI_COMM_WORLD);
+	if (my_rank == 0){
+		displacements[0] = 0;
+		for (i = 1; i < processes; i++)
+			displacements[i] = displacements[i-1] + lengths[i-1];
+		allbuffers = malloc(displacements[processes-1] + lengths[processes-1] + 1);
+	}
+	MPI_Gatherv(buffer, length, MPI_CHAR, allbuffers, lengths, displacements, MPI_CHAR, 0, MPI_COMM_WORLD);
+	MPI_Reduce(&objects, &allobjects, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+	MPI_Reduce(&unstable, &allunstable, 1, MPI_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+
+	finish = MPI_Wtime();
+	alltime = finish - start;
+
+	if (my_rank == 0){
+		census *all = createCensus();
+		unpackCensus(all, allbuffers, displacements[processes-1] + lengths[processes-1]);
+		showCensus(all);
+		deleteCensus(&all);
+
+		printf("\n///////////////////////////////////////////////////\n\n");
+		printf("--------------------------------------------------------------\n");
+		printf("Soups = %ld (not stable in %d generations = %ld)\n", soups, generations, allunstable);
+		printf("Objects = %ld\n", allobjects);
+		printf("Runtime = %f\n", alltime);
+		printf("Soups per second = %f\n", soups / alltime);
+		printf("Soups per second per core = %f\n", soups / alltime / (processes * thread_count));
+		printf("--------------------------------------------------------------\n");
+		free(lengths);
+		free(displacements);
+		free(allbuffers);
+	}
+	free(buffer);
+	deleteCensus(&local);
+
+	MPI_Finalize();						//End the MPI procedure
+
+	return 0;
+}
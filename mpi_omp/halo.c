@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "mpi.h"
+#include "halo.h"
+
+
+
+/*Create the datatypes of a halo r cells wide around the n x n interior of a padded (n+2r)x(n+2r) block*/
+/*0 - up/down side (r rows of n cells), 1 - left/right side (n rows of r cells), 2 - corner (r rows of r cells)*/
+void createHaloTypes(int n, int r, MPI_Datatype types[3])
+{
+	MPI_Type_vector(r, n, n+2*r, MPI_CHAR, &types[0]);
+	MPI_Type_vector(n, r, n+2*r, MPI_CHAR, &types[1]);
+	MPI_Type_vector(r, r, n+2*r, MPI_CHAR, &types[2]);
+	MPI_Type_commit(&types[0]);
+	MPI_Type_commit(&types[1]);
+	MPI_Type_commit(&types[2]);
+}
+
+
+
+/*Free the halo datatypes*/
+void freeHaloTypes(MPI_Datatype types[3])
+{
+	MPI_Type_free(&types[0]);
+	MPI_Type_free(&types[1]);
+	MPI_Type_free(&types[2]);
+}
+
+
+
+/*Post the non-blocking sends of the block's borders and the receives of the ghost frame (the caller waits for the 16 requests)*/
+/*The neighbours are given clockwise: upleft, up, upright, right, downright, down, downleft, left*/
+void exchangeHalo(char **pad, int n, int r, int neighbours[8], MPI_Datatype types[3], MPI_Comm comm, MPI_Request request[16])
+{
+	int d;
+	int  row[8]  = {r, r, r, r, n, n, n, r};						//Where each border to send starts (interior cells)
+	int  col[8]  = {r, r, n, n, n, r, r, r};
+	int  grow[8] = {n+r, n+r, n+r, r, 0, 0, 0, r};					//Where the ghost part received from the opposite neighbour starts
+	int  gcol[8] = {n+r, r, 0, 0, 0, r, n+r, n+r};
+	int  type[8] = {2, 0, 2, 1, 2, 0, 2, 1};
+
+	for (d = 0; d < 8; d++){
+		/*Send the border towards neighbour d and receive the same border of the opposite neighbour (tag d keeps the pairs apart)*/
+		MPI_Isend(&pad[row[d]][col[d]], 1, types[type[d]], neighbours[d], d, comm, &request[2*d]);
+		MPI_Irecv(&pad[grow[d]][gcol[d]], 1, types[type[d]], neighbours[(d+4)%8], d, comm, &request[2*d+1]);
+	}
+}
@@ -0,0 +1,503 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <omp.h>
+#include "unbounded.h"
+#include "soup.h"
+
+
+/*A live cell of the plane*/
+typedef struct point {
+	long i, j;
+} point;
+
+
+
+/*Create an empty census*/
+census *createCensus(void)
+{
+	census *c = malloc(sizeof(census));
+
+	c->size   = 256;
+	c->used   = 0;
+	c->names  = calloc(c->size, sizeof(char*));
+	c->counts = calloc(c->size, sizeof(long));
+	return c;
+}
+
+
+
+/*Delete a census and the names of its objects*/
+void deleteCensus(census **c)
+{
+	int k;
+	for (k = 0; k < (*c)->size; k++)
+		free((*c)->names[k]);
+	free((*c)->names);
+	free((*c)->counts);
+	free(*c);
+	*c = NULL;
+}
+
+
+
+/*Slot of an object in the hash map (FNV-1a of its name)*/
+static int hashName(const char *name, int size)
+{
+	uint64_t h = 14695981039346656037ULL;
+	for (; *name != '\0'; name++)
+		h = (h ^ (unsigned char)*name) * 1099511628211ULL;
+	return (int)(h & (uint64_t)(size - 1));
+}
+
+
+
+/*Count an object (found count times)*/
+void addToCensus(census *c, const char *name, long count)
+{
+	int  k, h, oldsize;
+	char **oldnames;
+	long *oldcounts;
+
+	h = hashName(name, c->size);
+	while ((c->names[h] != NULL) && strcmp(c->names[h], name))
+		h = (h + 1) & (c->size - 1);
+	if (c->names[h] != NULL){
+		c->counts[h] += count;
+		return;
+	}
+	c->names[h]  = strdup(name);
+	c->counts[h] = count;
+	c->used++;
+
+	if (2*c->used > c->size){					//Keep the hash map at most half full
+		oldnames  = c->names;
+		oldcounts = c->counts;
+		oldsize   = c->size;
+		c->size  *= 2;
+		c->names  = calloc(c->size, sizeof(char*));
+		c->counts = calloc(c->size, sizeof(long));
+		for (k = 0; k < oldsize; k++){
+			if (oldnames[k] == NULL) continue;
+			h = hashName(oldnames[k], c->size);
+			while (c->names[h] != NULL)
+				h = (h + 1) & (c->size - 1);
+			c->names[h]  = oldnames[k];
+			c->counts[h] = oldcounts[k];
+		}
+		free(oldnames);
+		free(oldcounts);
+	}
+}
+
+
+
+/*Add the objects of a census to another one*/
+void mergeCensus(census *into, census *from)
+{
+	int k;
+	for (k = 0; k < from->size; k++)
+		if (from->names[k] != NULL) addToCensus(into, from->names[k], from->counts[k]);
+}
+
+
+
+/*Write a census in a buffer as lines "name count", so that it can be sent to another process*/
+char *packCensus(census *c, int *length)
+{
+	int  k, used = 0, allocated = 1024;
+	char *buffer = malloc(allocated);
+
+	for (k = 0; k < c->size; k++){
+		if (c->names[k] == NULL) continue;
+		while (allocated - used < (int)strlen(c->names[k]) + 32){
+			allocated *= 2;
+			buffer = realloc(buffer, allocated);
+		}
+		used += sprintf(buffer + used, "%s %ld\n", c->names[k], c->counts[k]);
+	}
+	*length = used;
+	return buffer;
+}
+
+
+
+/*Add the objects of a buffer written by packCensus() to a census*/
+void unpackCensus(census *c, const char *buffer, int length)
+{
+	long count;
+	char *line, *space, *end;
+
+	line = malloc(length + 1);
+	memcpy(line, buffer, length);
+	line[length] = '\0';
+	for (end = line; (space = strchr(end, ' ')) != NULL; end++){
+		*space = '\0';
+		count = strtol(space + 1, &space, 10);
+		addToCensus(c, end, count);
+		end = space;							//The new line character after the count
+	}
+	free(line);
+}
+
+
+
+/*Order of objects when printed (most common first)*/
+static census *sorted;
+static int compareCounts(const void *a, const void *b)
+{
+	long ca = sorted->counts[*(int *)a], cb = sorted->counts[*(int *)b];
+	if (ca != cb) return (ca < cb) ? 1 : -1;
+	return strcmp(sorted->names[*(int *)a], sorted->names[*(int *)b]);
+}
+
+
+
+/*Print the objects of a census, most common first*/
+void showCensus(census *c)
+{
+	int k, n = 0, *order = malloc(c->used * sizeof(int));
+
+	for (k = 0; k < c->size; k++)
+		if (c->names[k] != NULL) order[n++] = k;
+	sorted = c;
+	qsort(order, n, sizeof(int), compareCounts);
+
+	printf("\n///////////////////////////////////////////////////\n\n");
+	for (k = 0; k < n; k++)
+		printf("%-32s %ld\n", c->names[order[k]], c->counts[order[k]]);
+	free(order);
+}
+
+
+
+/*Next random number of a stream (splitmix64, every thread keeps its own state)*/
+static uint64_t nextRandom(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+
+
+/*Put a random soup on the plane, the soup depends only on the seed and its number (not on the process or thread that runs it)*/
+void randomSoup(universe *u, uint64_t seed, long soup)
+{
+	int      i, j;
+	uint64_t state = seed ^ ((uint64_t)soup * 0xD1B54A32D192ED03ULL), bits = 0;
+
+	for (i = 0; i < SOUP_SIDE; i++){
+		for (j = 0; j < SOUP_SIDE; j++){
+			if ((i*SOUP_SIDE + j) % 64 == 0) bits = nextRandom(&state);
+			if (bits & 1) setCellUnbounded(u, i, j);
+			bits >>= 1;
+		}
+	}
+}
+
+
+
+/*Evolve a soup until it is stable, that is its population repeats with a period up to SOUP_MAX_PERIOD for SOUP_WINDOW generations*/
+/*The population is used instead of the cells, so that spaceships flying away count as stable (returns 0 if it is not stable in time)*/
+int runSoup(universe *u, int generations, char rule[2][9])
+{
+	int  q, p, k, allzeros, change, H = SOUP_WINDOW + SOUP_MAX_PERIOD;
+	long pop[SOUP_WINDOW + SOUP_MAX_PERIOD];
+
+	for (q = 0; q < generations; q++){
+		pop[q % H] = population(u);
+		if (pop[q % H] == 0) return 1;
+		if (q >= H-1){
+			for (p = 1; p <= SOUP_MAX_PERIOD; p++){
+				for (k = 0; k < SOUP_WINDOW; k++)
+					if (pop[(q-k) % H] != pop[(q-k-p) % H]) break;
+				if (k == SOUP_WINDOW) return 1;
+			}
+		}
+		allzeros = 0;
+		change   = 0;
+		evolveUnbounded(u, rule, &allzeros, &change);
+		if (!change) return 1;
+	}
+	return 0;
+}
+
+
+
+static int comparePoints(const void *a, const void *b)
+{
+	const point *pa = a, *pb = b;
+	if (pa->i != pb->i) return (pa->i < pb->i) ? -1 : 1;
+	if (pa->j != pb->j) return (pa->j < pb->j) ? -1 : 1;
+	return 0;
+}
+
+
+
+/*The live cells of the plane, sorted by row and column*/
+static point *liveCells(universe *u, int *n)
+{
+	int      k, i, count = 0;
+	uint64_t word;
+	chunk    *c;
+	point    *cells = malloc((population(u) + 1) * sizeof(point));
+
+	for (k = 0; k < u->count; k++){
+		c = u->chunks[k];
+		for (i = 0; i < CHUNK_SIZE; i++){
+			for (word = c->cells[i]; word != 0; word &= word - 1){
+				cells[count].i = c->ci*CHUNK_SIZE + i;
+				cells[count].j = c->cj*CHUNK_SIZE + __builtin_ctzll(word);
+				count++;
+			}
+		}
+	}
+	qsort(cells, count, sizeof(point), comparePoints);
+	*n = count;
+	return cells;
+}
+
+
+
+/*Move the cells so that their bounding box starts at (0, 0), after turning or mirroring them (transform 0..7), and sort them again*/
+static void normalize(point *cells, int n, int transform, long *i0, long *j0)
+{
+	int  k;
+	long t, mini, minj;
+
+	for (k = 0; k < n; k++){
+		if (transform & 4){ t = cells[k].i; cells[k].i = cells[k].j; cells[k].j = t; }
+		if (transform & 1) cells[k].i = -cells[k].i;
+		if (transform & 2) cells[k].j = -cells[k].j;
+	}
+	mini = minj = 0;
+	for (k = 0; k < n; k++){
+		if ((k == 0) || (cells[k].i < mini)) mini = cells[k].i;
+		if ((k == 0) || (cells[k].j < minj)) minj = cells[k].j;
+	}
+	for (k = 0; k < n; k++){
+		cells[k].i -= mini;
+		cells[k].j -= minj;
+	}
+	qsort(cells, n, sizeof(point), comparePoints);
+	if (i0 != NULL) *i0 = mini;
+	if (j0 != NULL) *j0 = minj;
+}
+
+
+
+/*Extended Wechsler format of normalized cells - strips of 5 rows, a character (0-9, a-v) for the 5 bits of every column of a strip,*/
+/*w, x, y for runs of 2, 3 and 4-35 empty columns and z between the strips*/
+static char *wechsler(const point *cells, int n)
+{
+	int  k, s, c, zeros, width = 0, height = 0, strips, used = 0, *columns;
+	char *code, digits[] = "0123456789abcdefghijklmnopqrstuv";
+
+	for (k = 0; k < n; k++){
+		if (cells[k].i + 1 > height) height = cells[k].i + 1;
+		if (cells[k].j + 1 > width) width = cells[k].j + 1;
+	}
+	strips  = (height + 4) / 5;
+	columns = calloc(strips*width, sizeof(int));
+	for (k = 0; k < n; k++)
+		columns[(cells[k].i / 5)*width + cells[k].j] |= 1 << (cells[k].i % 5);
+
+	code = malloc(strips*(width + 1) + 1);
+	for (s = 0; s < strips; s++){
+		if (s > 0) code[used++] = 'z';
+		zeros = 0;
+		for (c = 0; c < width; c++){
+			if (columns[s*width + c] == 0){
+				zeros++;
+				continue;
+			}
+			while (zeros > 0){						//The empty columns before a column with cells
+				if (zeros >= 4){
+					k = (zeros - 4 > 31) ? 31 : zeros - 4;
+					code[used++] = 'y';
+					code[used++] = digits[k];
+					zeros -= k + 4;
+				}
+				else if (zeros == 3){ code[used++] = 'x'; zeros = 0; }
+				else if (zeros == 2){ code[used++] = 'w'; zeros = 0; }
+				else { code[used++] = '0'; zeros = 0; }
+			}
+			code[used++] = digits[columns[s*width + c]];
+		}
+	}
+	code[used] = '\0';
+	free(columns);
+	return code;
+}
+
+
+
+/*Name of an object from its phases (xs for still lifes with their population, xp for oscillators and xq for spaceships with their*/
+/*period), with the shortest and then alphabetically first code of all of its phases, turned and mirrored in every way*/
+static char *objectName(point **phases, int *sizes, int period, int moves)
+{
+	int   p, t;
+	char  *code, *best = NULL, *name;
+	point *copy;
+
+	for (p = 0; p < period; p++){
+		copy = malloc(sizes[p] * sizeof(point));
+		for (t = 0; t < 8; t++){
+			memcpy(copy, phases[p], sizes[p] * sizeof(point));
+			normalize(copy, sizes[p], t, NULL, NULL);
+			code = wechsler(copy, sizes[p]);
+			if ((best == NULL) || (strlen(code) < strlen(best)) || ((strlen(code) == strlen(best)) && (strcmp(code, best) < 0))){
+				free(best);
+				best = code;
+			}
+			else free(code);
+		}
+		free(copy);
+	}
+
+	name = malloc(strlen(best) + 32);
+	if (moves) sprintf(name, "xq%d_%s", period, best);
+	else if (period == 1) sprintf(name, "xs%d_%s", sizes[0], best);
+	else sprintf(name, "xp%d_%s", period, best);
+	free(best);
+	return name;
+}
+
+
+
+/*Find what an object is, by evolving it alone until it is the same as in the beginning (somewhere else if it is a spaceship)*/
+static char *classifyObject(point *cells, int n, char rule[2][9])
+{
+	int      k, p, period = 0, moves = 0, allzeros, change, sizes[SOUP_MAX_PERIOD+1];
+	long     i0, j0, i1, j1;
+	char     *name;
+	point    *phases[SOUP_MAX_PERIOD+1];
+	universe *u = createUniverse();
+
+	for (k = 0; k < n; k++)
+		setCellUnbounded(u, cells[k].i, cells[k].j);
+	phases[0] = malloc(n * sizeof(point));
+	memcpy(phases[0], cells, n * sizeof(point));
+	sizes[0] = n;
+	normalize(phases[0], n, 0, &i0, &j0);
+
+	for (p = 1; (p <= SOUP_MAX_PERIOD) && (period == 0); p++){
+		evolveUnbounded(u, rule, &allzeros, &change);
+		phases[p] = liveCells(u, &(sizes[p]));
+		normalize(phases[p], sizes[p], 0, &i1, &j1);
+		if ((sizes[p] == n) && !memcmp(phases[p], phases[0], n * sizeof(point))){
+			period = p;
+			moves  = (i1 != i0) || (j1 != j0);
+		}
+	}
+
+	if (period > 0) name = objectName(phases, sizes, period, moves);
+	else {
+		name = malloc(32);
+		sprintf(name, "unknown_%d", n);				//Not periodic in SOUP_MAX_PERIOD generations (or a few objects close together)
+	}
+	for (k = 0; k < p; k++)
+		free(phases[k]);
+	deleteUniverse(&u);
+	return name;
+}
+
+
+
+static int findRoot(int *parent, int k)
+{
+	while (parent[k] != k){
+		parent[k] = parent[parent[k]];
+		k = parent[k];
+	}
+	return k;
+}
+
+
+
+/*Split the ash of a stable soup in objects (cells up to 2 apart belong to the same object) and count them in the census*/
+long splitAsh(universe *u, char rule[2][9], census *c)
+{
+	int   n, k, m, a, b, di, dj, start, *parent, *order;
+	long  objects = 0;
+	char  *name;
+	point *cells, *object, key, *found;
+
+	cells  = liveCells(u, &n);
+	parent = malloc((n + 1) * sizeof(int));
+	for (k = 0; k < n; k++)
+		parent[k] = k;
+	for (k = 0; k < n; k++){
+		for (di = -2; di <= 2; di++){
+			for (dj = -2; dj <= 2; dj++){
+				key.i = cells[k].i + di;
+				key.j = cells[k].j + dj;
+				found = bsearch(&key, cells, n, sizeof(point), comparePoints);
+				if (found == NULL) continue;
+				a = findRoot(parent, k);
+				b = findRoot(parent, found - cells);
+				if (a != b) parent[a] = b;
+			}
+		}
+	}
+
+	/*Cells of the same object one after the other (ordered by their root, a stable order keeps them sorted by row and column)*/
+	order  = malloc((n + 1) * sizeof(int));
+	object = malloc((n + 1) * sizeof(point));
+	for (k = 0; k < n; k++)
+		parent[k] = findRoot(parent, k);
+	m = 0;
+	for (k = 0; k < n; k++){
+		if (parent[k] != k) continue;
+		start = m;
+		for (a = 0; a < n; a++)
+			if (parent[a] == k) order[m++] = a;
+		for (a = start; a < m; a++)
+			object[a - start] = cells[order[a]];
+		name = classifyObject(object, m - start, rule);
+		addToCensus(c, name, 1);
+		free(name);
+		objects++;
+	}
+
+	free(cells);
+	free(parent);
+	free(order);
+	free(object);
+	return objects;
+}
+
+
+
+/*Search soups first, first+stride, ... (below soups) with the threads of this process, every thread keeps its own census and adds it to*/
+/*the census of the process only once in the end (returns the objects found, and in unstable the soups that were not stable in time)*/
+long searchSoups(uint64_t seed, long first, long soups, long stride, int generations, char rule[2][9], int thread_count, census *c, long *unstable)
+{
+	long k, objects = 0, notstable = 0;
+
+	#	pragma omp parallel num_threads(thread_count) \
+	default(none) shared(seed, first, soups, stride, generations, rule, c) private(k) reduction(+: objects, notstable)
+	{
+		census   *local = createCensus();
+		universe *u;
+
+		#	pragma omp for schedule(dynamic, 16)
+		for (k = first; k < soups; k += stride)
+		{
+			u = createUniverse();
+			randomSoup(u, seed, k);
+			if (!runSoup(u, generations, rule)) notstable++;
+			objects += splitAsh(u, rule, local);
+			deleteUniverse(&u);
+		}
+
+		#	pragma omp critical
+		mergeCensus(c, local);
+		deleteCensus(&local);
+	}
+	*unstable = notstable;
+	return objects;
+}
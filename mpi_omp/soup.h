@@ -0,0 +1,34 @@
+#ifndef __soup__
+#define __soup__
+
+#include <stdint.h>
+#include "unbounded.h"
+
+
+#define SOUP_SIDE       16			//Random soups are SOUP_SIDE x SOUP_SIDE cells (half of them alive)
+#define SOUP_MAX_PERIOD 30			//Longest period of oscillators and spaceships that are recognized
+#define SOUP_WINDOW     120			//Generations the population must repeat for, before the soup counts as stable
+
+
+/*Objects found and how many times (a hash map from the object's code to its count)*/
+typedef struct census {
+	char **names;
+	long *counts;
+	int  size, used;				//Size is a power of 2, at most half of it is used
+} census;
+
+
+census *createCensus(void);
+void deleteCensus(census **c);
+void addToCensus(census *c, const char *name, long count);
+void mergeCensus(census *into, census *from);
+char *packCensus(census *c, int *length);
+void unpackCensus(census *c, const char *buffer, int length);
+void showCensus(census *c);
+void randomSoup(universe *u, uint64_t seed, long soup);
+int runSoup(universe *u, int generations, char rule[2][9]);
+long splitAsh(universe *u, char rule[2][9], census *c);
+long searchSoups(uint64_t seed, long first, long soups, long stride, int generations, char rule[2][9], int thread_count, census *c, long *unstable);
+
+
+#endif
@@ -0,0 +1,325 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "unbounded.h"
+
+
+
+/*A rule with B0 fills the whole (infinite) empty plane in one generation, so it can not be run unbounded*/
+int checkUnboundedRule(char rule[2][9])
+{
+	return rule[0][0] ? -1 : 0;
+}
+
+
+
+/*Chunk of a row or column (rounding down, so that negative coordinates work as well)*/
+static long chunkOf(long x)
+{
+	return (x >= 0) ? x / CHUNK_SIZE : -((-x + CHUNK_SIZE - 1) / CHUNK_SIZE);
+}
+
+
+
+/*Slot of a chunk position in the hash map*/
+static int hashChunk(long ci, long cj, int tablesize)
+{
+	uint64_t h = (uint64_t)ci * 0x9E3779B97F4A7C15ULL ^ (uint64_t)cj * 0xC2B2AE3D27D4EB4FULL;
+	return (int)((h ^ (h >> 29)) & (uint64_t)(tablesize - 1));
+}
+
+
+
+/*Put every allocated chunk in the hash map again (after it grows or chunks are freed)*/
+static void rebuildTable(universe *u)
+{
+	int k, h;
+
+	memset(u->table, 0, u->tablesize * sizeof(chunk*));
+	for (k = 0; k < u->count; k++){
+		h = hashChunk(u->chunks[k]->ci, u->chunks[k]->cj, u->tablesize);
+		while (u->table[h] != NULL)
+			h = (h + 1) & (u->tablesize - 1);
+		u->table[h] = u->chunks[k];
+	}
+}
+
+
+
+/*Create an empty plane*/
+universe *createUniverse(void)
+{
+	universe *u = malloc(sizeof(universe));
+
+	u->count     = 0;
+	u->allocated = 64;
+	u->chunks    = malloc(u->allocated * sizeof(chunk*));
+	u->tablesize = 128;
+	u->table     = calloc(u->tablesize, sizeof(chunk*));
+	return u;
+}
+
+
+
+/*Delete the plane and all of its chunks*/
+void deleteUniverse(universe **u)
+{
+	int k;
+	for (k = 0; k < (*u)->count; k++)
+		free((*u)->chunks[k]);
+	free((*u)->chunks);
+	free((*u)->table);
+	free(*u);
+	*u = NULL;
+}
+
+
+
+/*Find the chunk in a position, or NULL if it is not allocated*/
+chunk *findChunk(universe *u, long ci, long cj)
+{
+	int h = hashChunk(ci, cj, u->tablesize);
+
+	while (u->table[h] != NULL){
+		if ((u->table[h]->ci == ci) && (u->table[h]->cj == cj)) return u->table[h];
+		h = (h + 1) & (u->tablesize - 1);
+	}
+	return NULL;
+}
+
+
+
+/*Allocate an empty chunk in a position (which must not have one)*/
+static chunk *addChunk(universe *u, long ci, long cj)
+{
+	int h;
+	chunk *c = calloc(1, sizeof(chunk));
+
+	c->ci = ci;
+	c->cj = cj;
+	if (u->count == u->allocated){
+		u->allocated *= 2;
+		u->chunks = realloc(u->chunks, u->allocated * sizeof(chunk*));
+	}
+	u->chunks[u->count++] = c;
+
+	if (2*u->count > u->tablesize){				//Keep the hash map at most half full
+		u->tablesize *= 2;
+		u->table = realloc(u->table, u->tablesize * sizeof(chunk*));
+		rebuildTable(u);
+	}
+	else {
+		h = hashChunk(ci, cj, u->tablesize);
+		while (u->table[h] != NULL)
+			h = (h + 1) & (u->tablesize - 1);
+		u->table[h] = c;
+	}
+	return c;
+}
+
+
+
+/*Make a cell alive*/
+void setCellUnbounded(universe *u, long i, long j)
+{
+	long  ci = chunkOf(i), cj = chunkOf(j);
+	chunk *c = findChunk(u, ci, cj);
+
+	if (c == NULL) c = addChunk(u, ci, cj);
+	c->cells[i - ci*CHUNK_SIZE] |= (uint64_t)1 << (j - cj*CHUNK_SIZE);
+}
+
+
+
+/*Value (0 or 1) of a cell*/
+int getCellUnbounded(universe *u, long i, long j)
+{
+	long  ci = chunkOf(i), cj = chunkOf(j);
+	chunk *c = findChunk(u, ci, cj);
+
+	if (c == NULL) return 0;
+	return (c->cells[i - ci*CHUNK_SIZE] >> (j - cj*CHUNK_SIZE)) & 1;
+}
+
+
+
+/*Number of live cells*/
+long population(universe *u)
+{
+	int  k, i;
+	long alive = 0;
+
+	for (k = 0; k < u->count; k++)
+		for (i = 0; i < CHUNK_SIZE; i++)
+			alive += __builtin_popcountll(u->chunks[k]->cells[i]);
+	return alive;
+}
+
+
+
+/*Smallest rectangle with all the live cells, as first row, first column, last row, last column (returns 0 if there are none)*/
+int boundingBox(universe *u, long box[4])
+{
+	int   k, i, found = 0;
+	long  row, first, last;
+	chunk *c;
+
+	for (k = 0; k < u->count; k++){
+		c = u->chunks[k];
+		for (i = 0; i < CHUNK_SIZE; i++){
+			if (c->cells[i] == 0) continue;
+			row   = c->ci*CHUNK_SIZE + i;
+			first = c->cj*CHUNK_SIZE + __builtin_ctzll(c->cells[i]);
+			last  = c->cj*CHUNK_SIZE + 63 - __builtin_clzll(c->cells[i]);
+			if (!found){
+				box[0] = box[2] = row;
+				box[1] = first;
+				box[3] = last;
+				found = 1;
+			}
+			if (row < box[0]) box[0] = row;
+			if (row > box[2]) box[2] = row;
+			if (first < box[1]) box[1] = first;
+			if (last > box[3]) box[3] = last;
+		}
+	}
+	return found;
+}
+
+
+
+/*Print the live cells in command line (only the rectangle that has them, after its position and the population)*/
+void showUnbounded(universe *u)
+{
+	long i, j, box[4];
+
+	printf("\n///////////////////////////////////////////////////\n\n");
+	if (!boundingBox(u, box)){
+		printf("Population 0\n");
+		return;
+	}
+	printf("Population %ld, rows %ld..%ld, columns %ld..%ld\n", population(u), box[0], box[2], box[1], box[3]);
+	for (i = box[0]; i <= box[2]; i++){
+		for (j = box[1]; j <= box[3]; j++){
+			if (getCellUnbounded(u, i, j)) printf("X");
+			else printf("-");
+		}
+		printf("\n");
+	}
+}
+
+
+
+/*Add a word of neighbours to the bit-sliced counters, s0..s3 are the 4 bits of the 64 counts (at most 8)*/
+#define ADD_NEIGHBOURS(a) { carry = s0 & (a); s0 ^= (a); carry2 = s1 & carry; s1 ^= carry; s3 |= s2 & carry2; s2 ^= carry2; }
+
+
+
+/*Next generation of one chunk (the words of the chunk and its sides, with the row above and below from the chunks there)*/
+static void evolveChunk(chunk *c, chunk *around[9], char rule[2][9])
+{
+	int      i, n;
+	uint64_t W[CHUNK_SIZE+2], C[CHUNK_SIZE+2], E[CHUNK_SIZE+2];
+	uint64_t s0, s1, s2, s3, carry, carry2, up, mid, down, alive, eq, next;
+
+	/*around[] holds the 3 x 3 chunks clockwise from up-left to left and the chunk itself last (NULL if not allocated)*/
+	W[0] = (around[0] != NULL) ? around[0]->cells[CHUNK_SIZE-1] : 0;
+	C[0] = (around[1] != NULL) ? around[1]->cells[CHUNK_SIZE-1] : 0;
+	E[0] = (around[2] != NULL) ? around[2]->cells[CHUNK_SIZE-1] : 0;
+	for (i = 0; i < CHUNK_SIZE; i++){
+		W[i+1] = (around[7] != NULL) ? around[7]->cells[i] : 0;
+		C[i+1] = c->cells[i];
+		E[i+1] = (around[3] != NULL) ? around[3]->cells[i] : 0;
+	}
+	W[CHUNK_SIZE+1] = (around[6] != NULL) ? around[6]->cells[0] : 0;
+	C[CHUNK_SIZE+1] = (around[5] != NULL) ? around[5]->cells[0] : 0;
+	E[CHUNK_SIZE+1] = (around[4] != NULL) ? around[4]->cells[0] : 0;
+
+	for (i = 1; i <= CHUNK_SIZE; i++){
+		s0 = s1 = s2 = s3 = 0;
+		up    = C[i-1];
+		mid   = C[i];
+		down  = C[i+1];
+		ADD_NEIGHBOURS((up << 1) | (W[i-1] >> 63));				//Up-left (column j-1 is bit j-1, so shift towards the high bits)
+		ADD_NEIGHBOURS(up);
+		ADD_NEIGHBOURS((up >> 1) | (E[i-1] << 63));				//Up-right
+		ADD_NEIGHBOURS((mid << 1) | (W[i] >> 63));
+		ADD_NEIGHBOURS((mid >> 1) | (E[i] << 63));
+		ADD_NEIGHBOURS((down << 1) | (W[i+1] >> 63));
+		ADD_NEIGHBOURS(down);
+		ADD_NEIGHBOURS((down >> 1) | (E[i+1] << 63));
+
+		/*Every count the rule gives a live cell for selects the cells with that count, all 64 at once*/
+		alive = mid;
+		next  = 0;
+		for (n = 0; n < 9; n++){
+			if (!rule[0][n] && !rule[1][n]) continue;
+			eq  = ((n & 1) ? s0 : ~s0) & ((n & 2) ? s1 : ~s1) & ((n & 4) ? s2 : ~s2) & ((n & 8) ? s3 : ~s3);
+			next |= eq & ((rule[0][n] ? ~alive : 0) | (rule[1][n] ? alive : 0));
+		}
+		c->next[i-1] = next;
+	}
+}
+
+
+
+/*The cells evolve - move to next generation, chunks are allocated where the pattern grows and freed where it dies*/
+void evolveUnbounded(universe *u, char rule[2][9], int *allzeros, int *change)
+{
+	int   k, i, d, n, count, empty;
+	long  di[8] = {-1, -1, -1, 0, 1, 1, 1, 0}, dj[8] = {-1, 0, 1, 1, 1, 0, -1, -1};
+	uint64_t top, bottom, left, right, edge[8];
+	chunk *c, *around[9];
+
+	/*Allocate the chunks next to the live cells on the edges of a chunk (only there cells can be born outside the allocated chunks)*/
+	count = u->count;
+	for (k = 0; k < count; k++){
+		c = u->chunks[k];
+		left = right = 0;
+		for (i = 0; i < CHUNK_SIZE; i++){
+			left  |= c->cells[i] & 1;
+			right |= c->cells[i] >> 63;
+		}
+		top    = c->cells[0];
+		bottom = c->cells[CHUNK_SIZE-1];
+		edge[0] = top & 1;
+		edge[1] = top;
+		edge[2] = top >> 63;
+		edge[3] = right;
+		edge[4] = bottom >> 63;
+		edge[5] = bottom;
+		edge[6] = bottom & 1;
+		edge[7] = left;
+		for (d = 0; d < 8; d++)
+			if (edge[d] && (findChunk(u, c->ci + di[d], c->cj + dj[d]) == NULL))
+				addChunk(u, c->ci + di[d], c->cj + dj[d]);
+	}
+
+	/*Evolve every chunk into its next[] rows*/
+	for (k = 0; k < u->count; k++){
+		c = u->chunks[k];
+		for (d = 0; d < 8; d++)
+			around[d] = findChunk(u, c->ci + di[d], c->cj + dj[d]);
+		around[8] = c;
+		evolveChunk(c, around, rule);
+	}
+
+	/*Move to the new generation and free the chunks that are left empty*/
+	n = 0;
+	for (k = 0; k < u->count; k++){
+		c = u->chunks[k];
+		if (memcmp(c->cells, c->next, sizeof(c->cells))) *change = 1;
+		memcpy(c->cells, c->next, sizeof(c->cells));
+		empty = 1;
+		for (i = 0; i < CHUNK_SIZE; i++)
+			if (c->cells[i]) empty = 0;
+		if (empty) free(c);
+		else u->chunks[n++] = c;
+	}
+	if (n != u->count){
+		u->count = n;
+		rebuildTable(u);
+	}
+	if (n > 0) *allzeros = 1;
+}
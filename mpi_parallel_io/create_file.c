@@ -1,35 +1,309 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <omp.h>
+#include "loader.h"
+#include "tiles.h"
 
 
+#define CHUNK (4 << 20)			//Bytes every thread writes with one pwrite() (at least one row)
+
+/*Formats of the output file*/
+#define GRID  0					//"0 1 0 ...", 2 bytes per cell (input of gol-mpi_parallel_io)
+#define CELLS 1					//"row column" of every live cell (input of the other programs)
+#define BITS  2					//Binary, (N+7)/8 bytes per row, cell j in bit j%8 of byte j/8
+#define TILES 3					//Binary, compressed tiles with an index (tiles.h)
+
+
+
+/*A 64 bit random number of a row (splitmix64), every row has its own sequence, so the board is the same for any number of threads*/
+static inline uint64_t nextRandom(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+	return z ^ (z >> 31);
+}
+
+
+
+/*The cells of row i: alive with probability threshold/65536 (16 bits of a random number for each cell), or where the tile of the*/
+/*pattern (period x period cells, repeated all over the board) has a live cell*/
+static void generateRow(char *row, int i, int N, unsigned int seed, uint32_t threshold, const char *tile, int period)
+{
+	int  j, k;
+	uint64_t state = ((uint64_t)seed << 32) ^ (uint64_t)i, bits;
+	const char *pattern;
+
+	if (threshold == 0) memset(row, 0, N);
+	else {
+		nextRandom(&state);
+		for (j = 0; j < N; j += 4){
+			bits = nextRandom(&state);
+			for (k = j; (k < j+4) && (k < N); k++, bits >>= 16)
+				row[k] = ((bits & 0xFFFF) < threshold);
+		}
+	}
+	if (tile != NULL){
+		pattern = tile + (size_t)(i % period)*period;
+		for (j = 0; j < N; j++)
+			row[j] |= pattern[j % period];
+	}
+}
+
+
+
+/*Write a number in text, returns its length*/
+static int writeNumber(char *out, int value)
+{
+	char digits[12];
+	int  k = 0, length;
+
+	do {
+		digits[k++] = '0' + value % 10;
+		value /= 10;
+	} while (value > 0);
+	for (length = 0; k > 0; length++)
+		out[length] = digits[--k];
+	return length;
+}
+
+
+
+/*Write the cells of row i in the format of the output file, returns the bytes written*/
+static size_t renderRow(char *out, const char *row, int i, int N, int format)
+{
+	int  j;
+	char *p = out;
+
+	if (format == GRID){
+		for (j = 0; j < N; j++){
+			p[2*j]   = '0' + row[j];
+			p[2*j+1] = ' ';
+		}
+		p[2*N-1] = '\n';
+		return (size_t)2*N;
+	}
+	if (format == BITS){
+		memset(p, 0, (N+7)/8);
+		for (j = 0; j < N; j++)
+			p[j/8] |= row[j] << (j%8);
+		return (N+7)/8;
+	}
+	for (j = 0; j < N; j++){
+		if (!row[j]) continue;
+		p += writeNumber(p, i);
+		*p++ = ' ';
+		p += writeNumber(p, j);
+		*p++ = '\n';
+	}
+	return p - out;
+}
+
+
+
+/*Write a buffer at an offset of the file (pwrite() may write only a part of it), returns -1 on error*/
+static int writeAt(int fd, const char *buffer, size_t length, off_t offset)
+{
+	ssize_t written;
+
+	while (length > 0){
+		written = pwrite(fd, buffer, length, offset);
+		if (written <= 0) return -1;
+		buffer += written;
+		length -= written;
+		offset += written;
+	}
+	return 0;
+}
+
+
+
+/*Read the live cells of a coordinates file (e.g. "Input Files/glider") in a period x period tile, returns NULL on error*/
+static char *readTile(const char *filename, int period)
+{
+	int  i, j;
+	char *tile;
+	mapped input;
+
+	if (mapInput(filename, &input) != 0) return NULL;
+	tile = calloc((size_t)period*period, sizeof(char));
+	while (nextCoordinates(&input, &i, &j))
+		tile[(i % period)*period + j % period] = 1;
+	unmapInput(&input);
+	return tile;
+}
+
+
+
+/*Compress the tiles of a band (T rows of packed cells, stride bytes each) one after the other in out, their offsets from the start*/
+/*of out go in offsets, returns the bytes written*/
+static size_t renderBand(unsigned char *out, const unsigned char *band, size_t stride, int T, int tiles, uint64_t *offsets)
+{
+	int  c;
+	size_t length = 0;
+
+	for (c = 0; c < tiles; c++){
+		offsets[c] = length;
+		length += encodeTile(out + length, band + (size_t)c*T/8, stride, T);
+	}
+	return length;
+}
+
+
+
+/*Board generator - In command line (example): ./create_file -n 65536 -f "./Input Files/f65536" -d 30 -s 1 -t 8*/
+/*Every thread generates some rows in its buffer and writes them with pwrite() at their place in the file, in rounds of one chunk per*/
+/*thread (the offsets of the chunks are known after each round, since in the coordinates format the rows have different lengths).*/
+/*In the tiled format a chunk is a band of one row of tiles, and the index is written at the start of the file in the end*/
 int main(int argc, char const *argv[])
 {
-	int  i, j, N, random, cell;
-	FILE *fp;
+	int  i, N = 0, random = -1, format = GRID, period = 0, thread_count = 4, rows, error = 0, T = TILE_SIDE, tiles = 0;
+	unsigned int seed = time(NULL);
+	double density = -1;
+	long alive = 0;
+	size_t rowbytes, *lengths;
+	off_t base = 0;
+	uint64_t *offsets = NULL;
+	unsigned char *header = NULL;
+	uint32_t threshold;
+	const char *filename = NULL, *patternfile = NULL;
+	char *tile = NULL;
+	int  fd;
 
 	for (i = 0; i < argc; i++){
 		if (!strcmp(argv[i], "-n")) N = atoi(argv[++i]);
-		else if (!strcmp(argv[i], "-f")) fp = fopen(argv[++i], "w");
+		else if (!strcmp(argv[i], "-f")) filename = argv[++i];
 		else if (!strcmp(argv[i], "-r")) random = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-d")) density = atof(argv[++i]);
+		else if (!strcmp(argv[i], "-s")) seed = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-t")) thread_count = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-p")) patternfile = argv[++i];
+		else if (!strcmp(argv[i], "-P")) period = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-T")) T = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-F")){
+			i++;
+			if (!strcmp(argv[i], "grid")) format = GRID;
+			else if (!strcmp(argv[i], "cells")) format = CELLS;
+			else if (!strcmp(argv[i], "bits")) format = BITS;
+			else if (!strcmp(argv[i], "tiles")) format = TILES;
+			else format = -1;
+		}
+	}
+
+	/*Check if the flag values are proper, or else exit*/
+	if ((N < 1) || (filename == NULL) || (format < 0) || (thread_count < 1) || (T < 8) || (T % 8 != 0)){
+		fprintf(stderr, "Usage: ./create_file -n <size> -f <file> [-d <density %%> | -r 0/1] [-s <seed>] [-t <threads>] [-F grid|cells|bits|tiles [-T <tile side, multiple of 8>]] [-p <pattern> -P <period>]\n");
+		return 1;
+	}
+	if (density < 0) density = (random == 0) ? 0 : ((random == 1) || (patternfile == NULL)) ? 50 : 0;		//-r 1 is the old 50% random board
+	if (density > 100) density = 100;
+	threshold = (uint32_t)(density / 100 * 65536);
+	if (patternfile != NULL){
+		if (period < 1){
+			fprintf(stderr, "A period (-P) is needed to tile the pattern %s\n", patternfile);
+			return 1;
+		}
+		tile = readTile(patternfile, period);
+		if (tile == NULL){
+			fprintf(stderr, "Cannot read the pattern %s\n", patternfile);
+			return 1;
+		}
+	}
+	fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0){
+		fprintf(stderr, "Cannot write the file %s\n", filename);
+		free(tile);
+		return 1;
 	}
 
-	srand(time(NULL));
+	/*Largest row in the format, and the rows of one chunk*/
+	rowbytes = (format == GRID) ? (size_t)2*N : (format == BITS) ? (size_t)(N+7)/8 : (size_t)N*24;
+	rows = CHUNK / rowbytes;
+	if (rows < 1) rows = 1;
+	if (format == TILES){
+		tiles    = tilesPerSide(N, T);
+		rowbytes = (size_t)tiles*T/8;						//Packed row of the band, with the columns out of the board
+		rows     = T;
+		offsets  = malloc(((size_t)tiles*tiles + 1) * sizeof(uint64_t));
+		base     = indexOffset((size_t)tiles*tiles + 1);	//The tiles start after the header and the index
+	}
+	lengths = calloc(thread_count, sizeof(size_t));
 
-	for (i = 0; i < N; i++)
+	#	pragma omp parallel num_threads(thread_count) \
+	default(none) shared(N, seed, threshold, tile, period, format, rowbytes, rows, lengths, base, fd, error, T, tiles, offsets) reduction(+: alive)
 	{
-		for (j = 0; j < N; j++)
-		{
-			if (!random) cell = 0;
-			else cell = rand() % 2;
+		int  t = omp_get_thread_num(), threads = omp_get_num_threads(), first, k, j;
+		size_t length;
+		off_t offset;
+		char *row = malloc(N), *buffer;
+		unsigned char *band = NULL;
+
+		if (format == TILES){
+			band   = malloc(rows * rowbytes);
+			buffer = malloc(tiles * tileBound(T));
+		}
+		else buffer = malloc(rows * rowbytes);
 
-			if (j != N-1) fprintf(fp, "%d ", cell);
-			else fprintf(fp, "%d", cell);
+		for (first = 0; first < N; first += threads*rows){
+			length = 0;
+			if (band != NULL) memset(band, 0, rows * rowbytes);		//The cells under and right of the board are 0
+			for (k = first + t*rows; (k < first + (t+1)*rows) && (k < N); k++){
+				generateRow(row, k, N, seed, threshold, tile, period);
+				for (j = 0; j < N; j++) alive += row[j];
+				if (band != NULL) renderRow((char *)band + (k - first - t*rows)*rowbytes, row, k, N, BITS);
+				else length += renderRow(buffer + length, row, k, N, format);
+			}
+			if ((band != NULL) && (first + t*rows < N))
+				length = renderBand((unsigned char *)buffer, band, rowbytes, T, tiles, offsets + (size_t)(first/T + t)*tiles);
+			lengths[t] = length;
+			#	pragma omp barrier
+
+			/*The chunk goes after the chunks of the threads before it*/
+			offset = base;
+			for (k = 0; k < t; k++) offset += lengths[k];
+			if (band != NULL) for (k = 0; (k < tiles) && (first + t*rows < N); k++)
+				offsets[(size_t)(first/T + t)*tiles + k] += offset;
+			if (writeAt(fd, buffer, length, offset) != 0){
+				#	pragma omp atomic write
+				error = 1;
+			}
+			#	pragma omp barrier
+			#	pragma omp single
+			{
+				for (k = 0; k < threads; k++) base += lengths[k];
+			}
 		}
-		fprintf(fp, "\n");
+		free(row);
+		free(band);
+		free(buffer);
+	}
+
+	/*The header and the index of the tiled format*/
+	if (format == TILES){
+		offsets[(size_t)tiles*tiles] = base;
+		header = malloc(indexOffset((size_t)tiles*tiles + 1));
+		writeTileHeader(header, N, T);
+		for (i = 0; i <= tiles*tiles; i++)
+			put64(header + indexOffset(i), offsets[i]);
+		if (writeAt(fd, (char *)header, indexOffset((size_t)tiles*tiles + 1), 0) != 0) error = 1;
+		free(header);
+		free(offsets);
+	}
+	close(fd);
+	free(lengths);
+	free(tile);
+	if (error){
+		fprintf(stderr, "Cannot write the file %s\n", filename);
+		return 1;
 	}
+	printf("Live cells = %ld\n", alive);
 	printf("Done!\n");
 
 	return 0;
-}
\ No newline at end of file
+}
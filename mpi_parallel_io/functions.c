@@ -1,5 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include "gol.h"
+#include "memory.h"
 
 
 
@@ -9,7 +11,7 @@ char **allocateArray(int n)
 	int  i, j;
 	char *p, **array;
 
-	p = malloc(n*n*sizeof(char));		//Allocate an 1D array of n*n contiguous chunks
+	p = allocateCells((size_t)n*n*sizeof(char));		//An 1D array of n*n contiguous chunks (aligned, from the pool, huge pages if large)
 	array = malloc(n*sizeof(char*));
 	for (i = 0; i < n; i++){			//Allocate a pointers array that points every row of the above 1D array
 		array[i] = &(p[i*n]);			//Just like a usual dynamically allocated 2D array
@@ -24,7 +26,7 @@ char **allocateArray(int n)
 /*Delete a 2D array created in the way above*/
 void deleteArray(char ***array)
 {
-	free(&((*array)[0][0]));			//Delete the initial 1D array with n*n items
+	releaseCells(&((*array)[0][0]));	//Give the initial 1D array with n*n items back to the pool
 	free(*array);						//Delete the pointers array (that shows every "row")
 }
 
@@ -47,158 +49,96 @@ void show(char **array, int N)
 
 
 
-/*The side cells evolve - move to next generation*/
-void evolve_sides(char **old_gen, char **new_gen, char **border, int N, int *allzeros, int *change)
+/*Write the cells in a file that other programs read (e.g. gol-verify): the side and the generations computed in the first line,*/
+/*then "row column state" for every cell that is not dead, row by row*/
+void dump(char **cells, int N, int generations, const char *filename)
 {
-	int i, j, neighbours;
-
-	/*Calculate the neighbours of cells in lines based on received_border array*/
-	for (j = 0; j < N; j++)
-	{															//Up line
-		neighbours = 0;
-		if ((j == 0) && (border[4][0] == 1)) neighbours++;				//Upleft
-		else if ((j != 0) && (border[5][j-1] == 1)) neighbours++;
-		if (border[5][j] == 1) neighbours++;							//Up
-		if ((j == N-1) && (border[6][0] == 1)) neighbours++;			//Upright
-		else if ((j != N-1) && (border[5][j+1] == 1)) neighbours++;
-		if ((j == N-1) && (border[7][0] == 1)) neighbours++;			//Right
-		else if ((j != N-1) && (old_gen[0][j+1] == 1)) neighbours++;
-		if ((j == N-1) && (border[7][1] == 1)) neighbours++;			//Downright
-		else if ((j != N-1) && (old_gen[1][j+1] == 1)) neighbours++;
-		if (old_gen[1][j] == 1) neighbours++;							//Down
-		if ((j == 0) && (border[3][1] == 1)) neighbours++;				//Downleft
-		else if ((j != 0) && (old_gen[1][j-1] == 1)) neighbours++;
-		if ((j == 0) && (border[3][0] == 1)) neighbours++;				//Left
-		else if ((j != 0) && (old_gen[0][j-1] == 1)) neighbours++;
-		/*--------------------------------------------------------------------------*/
-		if ((old_gen[0][j] == 1) && ((neighbours < 2) || (neighbours > 3)))
-			new_gen[0][j] = 0;
-		else if ((old_gen[0][j] == 0) && (neighbours == 3))
-			new_gen[0][j] = 1;
-		else new_gen[0][j] = old_gen[0][j];		//Assign new values in up line's cells (if alive or dead)
-
-		if (new_gen[0][j] != 0) *allzeros = 1;
-		if (new_gen[0][j] != old_gen[0][j]) *change = 1;
-
-																//Down line
-		neighbours = 0;
-		if ((j == 0) && (border[3][N-2] == 1)) neighbours++;			//Upleft
-		else if ((j != 0) && (old_gen[N-2][j-1] == 1)) neighbours++;
-		if (old_gen[N-2][j] == 1) neighbours++;							//Up
-		if ((j == N-1) && (border[7][N-2] == 1)) neighbours++;			//Upright
-		else if ((j != N-1) && (old_gen[N-2][j+1] == 1)) neighbours++;
-		if ((j == N-1) && (border[7][0] == 1)) neighbours++;			//Right
-		else if ((j != N-1) && (old_gen[N-1][j+1] == 1)) neighbours++;
-		if ((j == N-1) && (border[0][0] == 1)) neighbours++;			//Downright
-		else if ((j != N-1) && (border[1][j+1] == 1)) neighbours++;
-		if (border[1][j] == 1) neighbours++;							//Down
-		if ((j == 0) && (border[2][0] == 1)) neighbours++;				//Downleft
-		else if ((j != 0) && (border[1][j-1] == 1)) neighbours++;
-		if ((j == 0) && (border[3][0] == 1)) neighbours++;				//Left
-		else if ((j != 0) && (old_gen[N-1][j-1] == 1)) neighbours++;
-		/*--------------------------------------------------------------------------*/
-		if ((old_gen[N-1][j] == 1) && ((neighbours < 2) || (neighbours > 3)))
-			new_gen[N-1][j] = 0;
-		else if ((old_gen[N-1][j] == 0) && (neighbours == 3))
-			new_gen[N-1][j] = 1;
-		else new_gen[N-1][j] = old_gen[N-1][j];		//Assign new values in down line's cells (if alive or dead)
-
-		if (new_gen[N-1][j] != 0) *allzeros = 1;
-		if (new_gen[N-1][j] != old_gen[N-1][j]) *change = 1;
-	}
+	int  i, j;
+	FILE *fp = fopen(filename, "w");
 
-	/*Calculate the neighbours of cells in rows based on received_border array*/
-	for (i = 0; i < N; i++)
-	{															//Left line
-		neighbours = 0;
-		if ((i == 0) && (border[4][0] == 1)) neighbours++;				//Upleft
-		else if ((i != 0) && (border[3][i-1] == 1)) neighbours++;
-		if ((i == 0) && (border[5][0] == 1)) neighbours++;				//Up
-		else if ((i != 0) && (old_gen[i-1][0] == 1)) neighbours++;
-		if ((i == 0) && (border[5][1] == 1)) neighbours++;				//Upright
-		else if ((i != 0) && (old_gen[i-1][1] == 1)) neighbours++;
-		if (old_gen[i][1] == 1) neighbours++;							//Right
-		if ((i == N-1) && (border[1][1] == 1)) neighbours++;			//Downright
-		else if ((i != N-1) && (old_gen[i+1][1] == 1)) neighbours++;
-		if ((i == N-1) && (border[1][0] == 1)) neighbours++;			//Down
-		else if ((i != N-1) && (old_gen[i+1][0] == 1)) neighbours++;
-		if ((i == N-1) && (border[2][0] == 1)) neighbours++;			//Downleft
-		else if ((i != N-1) && (border[3][i+1] == 1)) neighbours++;
-		if (border[3][i] == 1) neighbours++;							//Left
-		/*--------------------------------------------------------------------------*/
-		if ((old_gen[i][0] == 1) && ((neighbours < 2) || (neighbours > 3)))
-			new_gen[i][0] = 0;
-		else if ((old_gen[i][0] == 0) && (neighbours == 3))
-			new_gen[i][0] = 1;
-		else new_gen[i][0] = old_gen[i][0];		//Assign new values in left row's cells (if alive or dead)
-
-		if (new_gen[i][0] != 0) *allzeros = 1;
-		if (new_gen[i][0] != old_gen[i][0]) *change = 1;
-
-																//Right line
-		neighbours = 0;
-		if ((i == 0) && (border[5][N-2] == 1)) neighbours++;			//Upleft
-		else if ((i != 0) && (old_gen[i-1][N-2] == 1)) neighbours++;
-		if ((i == 0) && (border[5][N-1] == 1)) neighbours++;			//Up
-		else if ((i != 0) && (old_gen[i-1][N-1] == 1)) neighbours++;
-		if ((i == 0) && (border[6][0] == 1)) neighbours++;				//Upright
-		else if ((i != 0) && (border[7][i-1] == 1)) neighbours++;
-		if (border[7][i] == 1) neighbours++;							//Right
-		if ((i == N-1) && (border[0][0] == 1)) neighbours++;			//Downright
-		else if ((i != N-1) && (border[7][i+1] == 1)) neighbours++;
-		if ((i == N-1) && (border[1][N-1] == 1)) neighbours++;			//Down
-		else if ((i != N-1) && (old_gen[i+1][N-1] == 1)) neighbours++;
-		if ((i == N-1) && (border[1][N-2] == 1)) neighbours++;			//Downleft
-		else if ((i != N-1) && (old_gen[i+1][N-2] == 1)) neighbours++;
-		if (old_gen[i][N-2] == 1) neighbours++;							//Left
-		/*--------------------------------------------------------------------------*/
-		if ((old_gen[i][N-1] == 1) && ((neighbours < 2) || (neighbours > 3)))
-			new_gen[i][N-1] = 0;
-		else if ((old_gen[i][N-1] == 0) && (neighbours == 3))
-			new_gen[i][N-1] = 1;
-		else new_gen[i][N-1] = old_gen[i][N-1];		//Assign new values in right row's cells (if alive or dead)
-
-		if (new_gen[i][N-1] != 0) *allzeros = 1;
-		if (new_gen[i][N-1] != old_gen[i][N-1]) *change = 1;
+	if (fp == NULL){
+		fprintf(stderr, "Cannot write the cells in %s\n", filename);
+		return;
 	}
+	fprintf(fp, "%d %d\n", N, generations);
+	for (i = 0; i < N; i++)
+		for (j = 0; j < N; j++)
+			if (cells[i][j] != 0) fprintf(fp, "%d %d %d\n", i, j, cells[i][j]);
+	fclose(fp);
 }
 
 
 
-/*The inner cells evolve (not the side ones)*/
-void evolve_inner(char **old_gen, char **new_gen, int N, int *allzeros, int *change)
+/*The cells in rows row0..row1-1 and columns col0..col1-1 of a padded block evolve, their neighbours are summed without any checks*/
+/*since the ghost frame holds the neighbours' cells around the block. If stats is not NULL the same sweep also counts the live cells,*/
+/*births and deaths of every row and widens the bounding box (only the columns still outside it are searched for its sides)*/
+static void evolve_region(char **old_gen, char **new_gen, int row0, int row1, int col0, int col1, char rule[2][9], int *allzeros, int *change, gol_stats *stats)
 {
-	int i, j, up, down, left, right, neighbours;
-
-	/*Calculate the "inside" cells, from (1,1) till (N-1,N-1)*/
-	for (i = 1; i < N-1; i++)
-	{										//Calculate up and down rows
-		up   = i-1;
-		down = i+1;
-
-		for (j = 1; j < N-1; j++)
-		{									//Calculate left and right columns
-			left  = j-1;
-			right = j+1;
-			neighbours = 0;
-
-			if (old_gen[up][left]    == 1) neighbours++;				//Check the neighbours
-			if (old_gen[up][j]       == 1) neighbours++;
-			if (old_gen[up][right]   == 1) neighbours++;
-			if (old_gen[i][right]    == 1) neighbours++;
-			if (old_gen[down][right] == 1) neighbours++;
-			if (old_gen[down][j]     == 1) neighbours++;
-			if (old_gen[down][left]  == 1) neighbours++;
-			if (old_gen[i][left]     == 1) neighbours++;
-
-			if ((old_gen[i][j] == 1) && ((neighbours < 2) || (neighbours > 3)))
-				new_gen[i][j] = 0;
-			else if ((old_gen[i][j] == 0) && (neighbours == 3))
-				new_gen[i][j] = 1;
-			else new_gen[i][j] = old_gen[i][j];		//Assign new values in "inside" cells (if alive or dead)
-
-			if (new_gen[i][j] != 0) *allzeros = 1;
-			if (new_gen[i][j] != old_gen[i][j]) *change = 1;
+	int  i, j, neighbours, population, births, deaths;
+	char *up, *mid, *down, *out, alive = 0, changed = 0;
+
+	for (i = row0; i < row1; i++){
+		up   = old_gen[i-1];
+		mid  = old_gen[i];
+		down = old_gen[i+1];
+		out  = new_gen[i];
+		if (stats == NULL){
+			for (j = col0; j < col1; j++){
+				neighbours = up[j-1] + up[j] + up[j+1] + mid[j-1] + mid[j+1] + down[j-1] + down[j] + down[j+1];
+				out[j]   = rule[(int)mid[j]][neighbours];		//Assign new values from the rule's transition table
+				alive   |= out[j];
+				changed |= out[j] ^ mid[j];
+			}
+			continue;
 		}
+
+		population = births = deaths = 0;
+		for (j = col0; j < col1; j++){
+			neighbours  = up[j-1] + up[j] + up[j+1] + mid[j-1] + mid[j+1] + down[j-1] + down[j] + down[j+1];
+			out[j]      = rule[(int)mid[j]][neighbours];
+			population += out[j];
+			births     += out[j] & ~mid[j];
+			deaths     += mid[j] & ~out[j];
+		}
+		stats->population += population;
+		stats->births     += births;
+		stats->deaths     += deaths;
+		alive   |= (population > 0);
+		changed |= (births + deaths > 0);
+		if (population == 0) continue;
+
+		if (i < stats->top) stats->top = i;
+		if (i > stats->bottom) stats->bottom = i;
+		for (j = col0; (j < col1) && (j < stats->left); j++)
+			if (out[j]){
+				stats->left = j;
+				break;
+			}
+		for (j = col1-1; (j >= col0) && (j > stats->right); j--)
+			if (out[j]){
+				stats->right = j;
+				break;
+			}
 	}
-}
\ No newline at end of file
+	if (alive) *allzeros = 1;
+	if (changed) *change = 1;
+}
+
+
+
+/*The side cells evolve - move to next generation (rows and columns 1 and N of the block, the ghost frame is all around them)*/
+void evolve_sides(char **old_gen, char **new_gen, int N, char rule[2][9], int *allzeros, int *change, gol_stats *stats)
+{
+	evolve_region(old_gen, new_gen, 1, 2, 1, N+1, rule, allzeros, change, stats);			//Up line
+	if (N > 1) evolve_region(old_gen, new_gen, N, N+1, 1, N+1, rule, allzeros, change, stats);		//Down line (the up one if N == 1)
+	evolve_region(old_gen, new_gen, 2, N, 1, 2, rule, allzeros, change, stats);			//Left row
+	evolve_region(old_gen, new_gen, 2, N, N, N+1, rule, allzeros, change, stats);			//Right row
+}
+
+
+
+/*The inner cells evolve (not the side ones), from (2,2) till (N-1,N-1) of the padded block*/
+void evolve_inner(char **old_gen, char **new_gen, int N, char rule[2][9], int *allzeros, int *change, gol_stats *stats)
+{
+	evolve_region(old_gen, new_gen, 2, N, 2, N, rule, allzeros, change, stats);
+}
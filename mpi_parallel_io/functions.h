@@ -1,12 +1,15 @@
 #ifndef __functions__
 #define __functions__
 
+#include "gol.h"
+
 
 char **allocateArray(int n);
 void deleteArray(char ***array);
 void show(char **cells, int N);
-void evolve_sides(char **old_gen, char **new_gen, char **border, int N, int *allzeros, int *change);
-void evolve_inner(char **old_gen, char **new_gen, int N, int *allzeros, int *change);
+void dump(char **cells, int N, int generations, const char *filename);
+void evolve_sides(char **old_gen, char **new_gen, int N, char rule[2][9], int *allzeros, int *change, gol_stats *stats);
+void evolve_inner(char **old_gen, char **new_gen, int N, char rule[2][9], int *allzeros, int *change, gol_stats *stats);
 
 
 #endif
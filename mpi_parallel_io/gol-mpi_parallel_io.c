@@ -5,6 +5,15 @@
 #include <math.h>
 #include "mpi.h"
 #include "functions.h"
+#include "halo.h"
+#include "rules.h"
+#include "trace.h"
+#include "memory.h"
+#include "loader.h"
+#include "tiles.h"
+#include "tileread.h"
+#include "stats.h"
+#include "counters.h"
 
 
 #define BUFSIZE 64
@@ -17,7 +26,10 @@ int main(int argc, char *argv[])
 	int  i, j, N = 8, SideBlocks, SideProcesses, generations = 3;
 	int  processes, my_rank, output = 0, doom = 0;
 	int  nozero, diff, allzeros, change;
-	char **cells, **blocks, filename[BUFSIZE];
+	char **cells, **blocks, rule[2][9], *rulestring = "B3/S23", *tracefile = NULL, *dumpfile = NULL, *statsfile = NULL, filename[BUFSIZE];
+	int  counting = 0, available = 0, allavailable;
+	long long kernelcounts[2][COUNTERS+1] = {{0}}, allcounts[2][COUNTERS+1], innercells, sidecells;
+	const char *kernels[2] = {"evolve_inner", "evolve_sides"};
 
 
 	/*Initialize MPI to share the calculations between different processors*/
@@ -34,22 +46,40 @@ int main(int argc, char *argv[])
 		else if (!strcmp(argv[i], "-o1")) output = 1;
 		else if (!strcmp(argv[i], "-o2")) output = 2;
 		else if (!strcmp(argv[i], "-d")) doom = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-r")) rulestring = argv[++i];
+		else if (!strcmp(argv[i], "-T")) tracefile = argv[++i];
+		else if (!strcmp(argv[i], "-w")) dumpfile = argv[++i];
+		else if (!strcmp(argv[i], "-S")) statsfile = argv[++i];
+		else if (!strcmp(argv[i], "-c")) counting = 1;
+	}
+
+	/*Build the transition table of the rule (Conway's B3/S23 by default), or else exit*/
+	if (parseRule(rulestring, rule) != 0){
+		if (my_rank == 0) fprintf(stderr, "Invalid rule %s (B/S notation is expected, e.g. B36/S23)\n", rulestring);
+		MPI_Abort(MPI_COMM_WORLD, 1);
 	}
 
 	cells = allocateArray(N);		//Allocate memory for cells array and initialize it with 0s
 
-	/*Allocate memory for cells array, initialize it with 0s and check if the flag values are proper*/
+	/*Every process maps the whole input file in memory (without reading it, only the pages of its block are brought in later)*/
+	mapped input;
+	if (mapInput(filename, &input) != 0){
+		if (my_rank == 0) fprintf(stderr, "Cannot read the input file %s\n", filename);
+		MPI_Abort(MPI_COMM_WORLD, 1);
+	}
+
+	/*A tiled file (create_file -F tiles) starts with a header, otherwise it is a grid*/
+	int  tiled, side, tileside;
+	tiled = (readTileHeader((unsigned char *)input.text, input.length, &side, &tileside) == 0);
+
+	/*Check if the flag values are proper*/
 	if (my_rank == 0)
 	{
 		/*Check if the input file and command line's size are similar, or else exit*/
-		FILE *fp1 = fopen(filename, "r");
-		fseek(fp1, 0, SEEK_END);
-		int size = ftell(fp1);
-		if (size != (N*N*2)){
+		if (tiled ? (side != N) : (input.length != (size_t)N*N*2)){
 			printf("Different input file's from command line's array size!\n");
 			MPI_Abort(MPI_COMM_WORLD, 1);
 		}
-		fclose(fp1);
 
 		/*Check if the number of processes are powers, or else exit*/
 		float blockside = sqrt((float)processes);
@@ -60,14 +90,15 @@ int main(int argc, char *argv[])
 	}
 
 	/*Start timer - finish just before MPI_Finalize()*/
-	double start, finish;
+	double start, finish, t = 0.0;
 	MPI_Barrier(MPI_COMM_WORLD);
 	start = MPI_Wtime();
+	if (tracefile != NULL) traceStart(tracefile, generations, start);		//Time every phase of every generation (-T in cmd)
 
 	/*Allocate memory for blocks in every process*/
 	SideProcesses = (int) sqrt((float)processes);
 	SideBlocks = (int) (N / SideProcesses);
-	blocks = allocateArray(SideBlocks);
+	blocks = allocateArray(SideBlocks+2);			//A ghost frame one cell wide surrounds each block
 
 
 	/*Create a datatype for the subarrays (blocks) of the global cells array*/
@@ -79,6 +110,13 @@ int main(int argc, char *argv[])
 	MPI_Type_create_resized(type, 0, SideBlocks*sizeof(char), &subarraytype);				//Extend the above type
 	MPI_Type_commit(&subarraytype);															//Commit the subarray datatype
 
+	/*Only the interior of the blocks is scattered and gathered, without their ghost frame*/
+	int blocksizes[2]  = {SideBlocks+2, SideBlocks+2};
+	int blockstarts[2] = {1, 1};
+	MPI_Datatype blocktype;
+	MPI_Type_create_subarray(2, blocksizes, subsizes, blockstarts, MPI_ORDER_C, MPI_CHAR, &blocktype);
+	MPI_Type_commit(&blocktype);
+
 	/*Scatter the array to all processors*/
 	int counts[processes], starting_point[processes], displacement;
 	if (my_rank == 0){
@@ -94,25 +132,15 @@ int main(int argc, char *argv[])
 		}
 	}
 
-	/*Read from input file the proper block of data (for each process) and copy them to blocks array (parallel IO here)*/
-	char *line, *token, delim[2] = " ";
-	line = malloc(2*SideBlocks * sizeof(char));
-	MPI_File fp;
-	MPI_Status stat;
-	MPI_Offset start_offset;
-	MPI_File_open(MPI_COMM_WORLD, filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fp);
-	start_offset = ((my_rank/SideProcesses) * SideBlocks*(N*2)) + ((my_rank % SideProcesses) * (SideBlocks*2));		//Proper indexing
-	for (i = 0; i < SideBlocks; i++){
-		MPI_File_seek(fp, (start_offset + i*2*N), MPI_SEEK_SET);			//Indexing for reading
-		MPI_File_read(fp, line, (2*SideBlocks), MPI_CHAR, &stat);
-		token = strtok(line, delim);
-		blocks[i][0] = atoi(token);
-		for (j = 1; j < SideBlocks; j++){				//Copy each value in the proper cell
-			token = strtok(NULL, delim);
-			blocks[i][j] = atoi(token);
-		}
+	/*Read from the mapped input file the proper block of data (for each process) and copy them to blocks array (parallel IO here),*/
+	/*inside the ghost frame. Every cell takes 2 bytes, so the block of each process is found without scanning the file, while from a*/
+	/*tiled file only the tiles over the block are read (with MPI_File_read_at_all() at the offsets of its index)*/
+	if (!tiled) readGrid(&input, N, (my_rank/SideProcesses) * SideBlocks, (my_rank % SideProcesses) * SideBlocks, SideBlocks, SideBlocks, blocks, 1);
+	unmapInput(&input);
+	if (tiled && (readTiles(filename, N, tileside, (my_rank/SideProcesses) * SideBlocks, (my_rank % SideProcesses) * SideBlocks, SideBlocks, SideBlocks, blocks, 1, MPI_COMM_WORLD) != 0)){
+		fprintf(stderr, "The tiled file %s is damaged\n", filename);
+		MPI_Abort(MPI_COMM_WORLD, 1);
 	}
-	MPI_File_close(&fp);			//Close file descriptor
 
 
 	/*The subarrays must arranged as Cartesian coordinate structure for proper communication between the local ones*/
@@ -151,69 +179,77 @@ int main(int argc, char *argv[])
 	neighbour[0] = coords[0];
 	neighbour[1] = coords[1] - 1;
 	MPI_Cart_rank(new_comm, neighbour, &left);				//Left
+	int neighbours[8] = {upleft, up, upright, right, downright, down, downleft, left};
 
 
-	/*Declare waitall() variables and arrays for copy a line or cell (neighbour_border) and receive (received_border)*/
-	MPI_Request request[8];
-	MPI_Status  status[8];
-	char *neighbour_border, side_border[SideBlocks], **received_border, *help1, **help2;
-	neighbour_border = malloc(SideBlocks * sizeof(char));
-	help1 = neighbour_border;											//Copy array - neighbour_border
-	received_border = malloc(8 * sizeof(char*));
-	for (i = 0; i < 8; i++)												//Paste (receive) array - received_border
-		received_border[i] = malloc(SideBlocks * sizeof(char));
-	help2 = received_border;
+	/*Declare waitall() variables for the 8 sends and the 8 receives of the ghost frame, and the datatypes of its sides and corners*/
+	MPI_Request request[16];
+	MPI_Status  status[16];
+	MPI_Datatype halotypes[3];
+	createHaloTypes(SideBlocks, 1, halotypes);
 
 	/*A temporary array to find the new values of cells for the next generation and then copy it to blocks array*/
 	char **new_gen, **swap;
-	new_gen = allocateArray(SideBlocks);
+	new_gen = allocateArray(SideBlocks+2);
+
+	/*Hardware counters around the kernels of the inner and the side cells in every process (-c in cmd)*/
+	innercells = (SideBlocks > 2) ? (long long)(SideBlocks-2)*(SideBlocks-2) : 0;
+	sidecells  = (long long)SideBlocks*SideBlocks - innercells;
+	if (counting) available = countersOpen();
+
+	/*Population, births, deaths and bounding box of every generation, counted by the kernels in each block (-S in cmd)*/
+	gol_stats blockstats, *stats = NULL;
+	int  row0 = (my_rank / SideProcesses) * SideBlocks - 1, col0 = (my_rank % SideProcesses) * SideBlocks - 1;		//Board place of blocks[0][0]
+	if (statsfile != NULL){
+		if (statsStart(statsfile, my_rank, MPI_COMM_WORLD) != 0){
+			fprintf(stderr, "Cannot write the statistics in %s\n", statsfile);
+			MPI_Abort(MPI_COMM_WORLD, 1);
+		}
+		stats = &blockstats;
+	}
 
 
+	/*The ghost frame of the first generation is posted before the loop, then in every generation the side cells are computed first*/
+	/*and their new values are sent for the next one, so that the messages travel while the inner cells evolve*/
+	if (generations > 1) exchangeHalo(blocks, SideBlocks, 1, neighbours, halotypes, MPI_COMM_WORLD, request);
+
 	/*All generations are sychronized and each output is shown by the master process*/
 	for (i = 0; i < generations; i++)
 	{
-		if ((my_rank == 0) && (output == 2))
-			show(cells, N);						//Print the cells array as modified in this generation (-o2 in cmd)
+		TRACE_MARK(t);
+		if (output == 2){
+			if (my_rank == 0) show(cells, N);	//Print the cells array as modified in this generation (-o2 in cmd)
+			TRACE_PHASE(TRACE_OUTPUT, i, t);
+		}
 
 		if (i != generations-1)
 		{
-			/*Send the border 1D (line) arrays to the proper neighbour, who receives this neighbouring line or cell*/
-			neighbour_border = &(blocks[0][0]);
-			MPI_Isend(neighbour_border, 1, MPI_CHAR, upleft, 0, MPI_COMM_WORLD, &request[0]);
-			MPI_Irecv(received_border[0], 1, MPI_CHAR, downright, 0, MPI_COMM_WORLD, &request[1]);			// 0 - downright cell
-			neighbour_border = &(blocks[0][0]);
-			MPI_Isend(neighbour_border, SideBlocks, MPI_CHAR, up, 0, MPI_COMM_WORLD, &request[2]);
-			MPI_Irecv(received_border[1], SideBlocks, MPI_CHAR, down, 0, MPI_COMM_WORLD, &request[3]);		// 1 - down side
-			neighbour_border = &(blocks[0][SideBlocks-1]);
-			MPI_Isend(neighbour_border, 1, MPI_CHAR, upright, 0, MPI_COMM_WORLD, &request[4]);
-			MPI_Irecv(received_border[2], 1, MPI_CHAR, downleft, 0, MPI_COMM_WORLD, &request[5]);			// 2 - downleft cell
-			for (j = 0; j < SideBlocks; j++)
-				side_border[j] = blocks[j][SideBlocks-1];
-			MPI_Isend(side_border, SideBlocks, MPI_CHAR, right, 0, MPI_COMM_WORLD, &request[6]);
-			MPI_Irecv(received_border[3], SideBlocks, MPI_CHAR, left, 0, MPI_COMM_WORLD, &request[7]);		// 3 - left side
-			neighbour_border = &(blocks[SideBlocks-1][SideBlocks-1]);
-			MPI_Isend(neighbour_border, 1, MPI_CHAR, downright, 0, MPI_COMM_WORLD, &request[8]);
-			MPI_Irecv(received_border[4], 1, MPI_CHAR, upleft, 0, MPI_COMM_WORLD, &request[9]);				// 4 - upleft cell
-			neighbour_border = &(blocks[SideBlocks-1][0]);
-			MPI_Isend(neighbour_border, SideBlocks, MPI_CHAR, down, 0, MPI_COMM_WORLD, &request[10]);
-			MPI_Irecv(received_border[5], SideBlocks, MPI_CHAR, up, 0, MPI_COMM_WORLD, &request[11]);		// 5 - up side
-			neighbour_border = &(blocks[SideBlocks-1][0]);
-			MPI_Isend(neighbour_border, 1, MPI_CHAR, downleft, 0, MPI_COMM_WORLD, &request[12]);
-			MPI_Irecv(received_border[6], 1, MPI_CHAR, upright, 0, MPI_COMM_WORLD, &request[13]);			// 6 - upright cell
-			for (j = 0; j < SideBlocks; j++)
-				side_border[j] = blocks[j][0];
-			MPI_Isend(side_border, SideBlocks, MPI_CHAR, left, 0, MPI_COMM_WORLD, &request[14]);
-			MPI_Irecv(received_border[7], SideBlocks, MPI_CHAR, right, 0, MPI_COMM_WORLD, &request[15]);	// 7 - right side
-
 			allzeros = 0;				//Check if there are all 0s (at least one 1, then evolve function returns 1 in allzeros variable)
 			change   = 0;				//Check if the new generation is similar to the previous one (if not change is returned as 1)
+			if (statistics) gol_stats_clear(&blockstats);
+
+			MPI_Waitall(16, request, status);	//The ghost frame of this generation (posted in the previous one) is in
+			TRACE_PHASE(TRACE_WAIT, i, t);
+
+			if (counting) countersStart();
+			evolve_sides(blocks, new_gen, SideBlocks, rule, &allzeros, &change, stats);		//Evolve the side cells of blocks
+			if (counting) countersStop(kernelcounts[1], sidecells);
+			TRACE_PHASE(TRACE_SIDES, i, t);
 
-			evolve_inner(blocks, new_gen, SideBlocks, &allzeros, &change);		//Until send-receive is done, compute the inner cells
+			/*The new sides leave at once for the next generation (straight in the ghost frame of new_gen) while the inner cells evolve*/
+			if (i+1 != generations-1) exchangeHalo(new_gen, SideBlocks, 1, neighbours, halotypes, MPI_COMM_WORLD, request);
+			TRACE_PHASE(TRACE_HALO, i, t);
 
-			MPI_Waitall(8, request, status);	//Wait for all 8 non-blocking send and receives
-			MPI_Barrier(MPI_COMM_WORLD);		//Wait for all processes to send and receive the neighbouring cells (must evolve simultaneously)
+			if (counting) countersStart();
+			evolve_inner(blocks, new_gen, SideBlocks, rule, &allzeros, &change, stats);
+			if (counting) countersStop(kernelcounts[0], innercells);
+			TRACE_PHASE(TRACE_INNER, i, t);
 
-			evolve_sides(blocks, new_gen, received_border, SideBlocks, &allzeros, &change);		//Evolve the side cells of blocks
+			/*The statistics of the blocks are reduced in batches of generations, while the next ones evolve*/
+			if (statistics){
+				statsRecord(i+1, &blockstats, row0, col0);
+				TRACE_PHASE(TRACE_REDUCE, i, t);
+			}
 
 			/*Terminal checking (every 10 generations), if the array is still the same or is full of 0s, then stop the program*/
 			if ((doom == 1) && ((i % 10) == 0) && (i != 0)){
@@ -223,6 +259,7 @@ int main(int argc, char *argv[])
 					fprintf(stderr, "Program terminated (nothing changed or all extinguisted in this generation)\n");
 					MPI_Abort(MPI_COMM_WORLD, 1);
 				}
+				TRACE_PHASE(TRACE_REDUCE, i, t);
 			}
 
 			swap    = blocks;
@@ -230,28 +267,33 @@ int main(int argc, char *argv[])
 			new_gen = swap;
 
 			/*After each generation, gather all the blocks (with their new values) into the initial cells array (-o2 in cmd)*/
-			if (output == 2)
-				MPI_Gatherv(&(blocks[0][0]), N*N/processes, MPI_CHAR, &(cells[0][0]), counts, starting_point, subarraytype, 0, MPI_COMM_WORLD);
+			if (output == 2){
+				MPI_Gatherv(&(blocks[0][0]), 1, blocktype, &(cells[0][0]), counts, starting_point, subarraytype, 0, MPI_COMM_WORLD);
+				TRACE_PHASE(TRACE_OUTPUT, i, t);
+			}
 		}
 	}
-	/*After all processes are done, gather the blocks with their new values into the initial cells array (Whether there is output or not)*/
-	MPI_Gatherv(&(blocks[0][0]), N*N/processes, MPI_CHAR, &(cells[0][0]), counts, starting_point, subarraytype, 0, MPI_COMM_WORLD);
+	statsFinish();						//Reduce and write the statistics of the last generations
 
+	/*After all processes are done, gather the blocks with their new values into the initial cells array (Whether there is output or not)*/
+	TRACE_MARK(t);
+	MPI_Gatherv(&(blocks[0][0]), 1, blocktype, &(cells[0][0]), counts, starting_point, subarraytype, 0, MPI_COMM_WORLD);
+	TRACE_PHASE(TRACE_OUTPUT, generations-1, t);
 
-	for (i = 0; i < 8; i++)
-		free(help2[i]);					//Delete received_border 2D array (for receiving side cells depending on topology)
-	free(help2);
-	free(help1);						//Delete neighbour_border array (for copying side cells)
 
 	if (my_rank == 0){
 		if (output == 1)
 			show(cells, N);				//If told from command line, print the array (-o1 in cmd)
+		if (dumpfile != NULL)
+			dump(cells, N, (generations > 0) ? generations-1 : 0, dumpfile);		//Write the final cells in a file (-w in cmd)
 		deleteArray(&cells);			//Delete cells array
 	}
 	deleteArray(&blocks);				//Delete blocks array on each process
 	deleteArray(&new_gen);				//Delete the temporary array for copying new values
 
 	MPI_Type_free(&subarraytype);		//Free the subarray type
+	MPI_Type_free(&blocktype);			//Free the block interior and ghost frame types
+	freeHaloTypes(halotypes);
 
 
 	/*Stop timer and calculate the whole time of mpi procedures (generally the program time)*/
@@ -263,6 +305,11 @@ int main(int argc, char *argv[])
 	MPI_Reduce(&alltime, &maxtime, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
 	MPI_Reduce(&alltime, &mintime, 1, MPI_DOUBLE, MPI_MIN, 0, MPI_COMM_WORLD);
 	MPI_Reduce(&alltime, &sumtime, 1, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+	if (counting){
+		MPI_Reduce(kernelcounts, allcounts, 2*(COUNTERS+1), MPI_LONG_LONG, MPI_SUM, 0, MPI_COMM_WORLD);
+		MPI_Reduce(&available, &allavailable, 1, MPI_INT, MPI_BAND, 0, MPI_COMM_WORLD);		//Only the counters that all processes have
+		countersClose();
+	}
 	if (my_rank == 0){
 		printf("\n///////////////////////////////////////////////////\n\n");
 		printf("--------------------------------------------------------------\n");
@@ -270,8 +317,11 @@ int main(int argc, char *argv[])
 		printf("Minimum Runtime = %f\n", mintime);
 		printf("Average Runtime = %f\n", sumtime/processes);
 		printf("--------------------------------------------------------------\n");
+		if (counting) countersShow(allcounts, kernels, 2, allavailable);
 	}
+	traceFinish(MPI_COMM_WORLD, my_rank, processes);		//Write the trace and the time of each phase (-T in cmd)
 
+	emptyPool();						//Return the buffers of the pool to the system
 	MPI_Finalize();						//End the MPI procedure
 
 	return 0;
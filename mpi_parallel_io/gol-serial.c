@@ -2,18 +2,26 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include "rules.h"
+#include "memory.h"
+#include "loader.h"
+#include "counters.h"
 
 
+#define FRAME 2				//Width of the ghost frame (two cells, so that -2 computes two generations without filling it again)
 
-/*Allocate memory for a 2D array and initialize it*/
-char **allocateArray(int n, int init_flag)
+
+
+/*Allocate memory for a 2D array of rows x n cells with contiguous memory and initialize it*/
+char **allocateArray(int rows, int n, int init_flag)
 {
-	char **array;
+	char *p, **array;
 	int  i, j;
 
-	array = malloc(n * sizeof(char*));
-	for (i = 0; i < n; i++){
-		array[i] = malloc(n * sizeof(char));
+	p = allocateCells((size_t)rows*n*sizeof(char));		//Aligned, from the pool, huge pages if large
+	array = malloc(rows * sizeof(char*));
+	for (i = 0; i < rows; i++){
+		array[i] = &(p[i*n]);
 		for (j = 0; j < n; j++){
 			if (init_flag == 0) array[i][j] = 0;			//Initialize the array items as 0s
 			else array[i][j] = rand() % 2;
@@ -24,24 +32,22 @@ char **allocateArray(int n, int init_flag)
 
 
 
-/*Delete a 2D array which has dynamically allocated*/
-void deleteArray(char **array, int n)
+/*Delete a 2D array created in the way above*/
+void deleteArray(char **array)
 {
-	int i;
-	for (i = 0; i < n; i++)
-		free(array[i]);
+	releaseCells(array[0]);
 	free(array);
 }
 
 
 
-/*Print the cells in command line*/
+/*Print the cells in command line (the N x N cells start at [FRAME][FRAME], after the ghost frame)*/
 void show(char **cells, int N)
 {
 	int i, j;
 	printf("\n///////////////////////////////////////////////////\n\n");
-	for (i = 0; i < N; i++){
-		for (j = 0; j < N; j++){
+	for (i = FRAME; i < N+FRAME; i++){
+		for (j = FRAME; j < N+FRAME; j++){
 			if (cells[i][j] == 0) printf("-");
 			else if (cells[i][j] == 1) printf("X");
 			else printf("?");
@@ -52,28 +58,83 @@ void show(char **cells, int N)
 
 
 
-/*The cells evolve - move to next generation*/
-void evolve(char **old_gen, char **new_gen, int N)
+/*Write the cells in a file that other programs read (e.g. gol-verify): the side and the generations computed in the first line,*/
+/*then "row column state" for every cell that is not dead, row by row*/
+void dump(char **cells, int N, int generations, const char *filename)
 {
-	int i, j, ul, u, ur, l, r, dl, d, dr, neighbors;
+	int  i, j;
+	FILE *fp = fopen(filename, "w");
 
+	if (fp == NULL){
+		fprintf(stderr, "Cannot write the cells in %s\n", filename);
+		return;
+	}
+	fprintf(fp, "%d %d\n", N, generations);
 	for (i = 0; i < N; i++)
-	{
 		for (j = 0; j < N; j++)
-		{
-			ul = old_gen[((i-1)+N)%N][((j-1)+N)%N]; 
-			u  = old_gen[((i-1)+N)%N][((j)+N)%N];
-			ur = old_gen[((i-1)+N)%N][((j+1)+N)%N];
-			l  = old_gen[((i)+N)%N][((j-1)+N)%N];
-			r  = old_gen[((i)+N)%N][((j+1)+N)%N];
-			dl = old_gen[((i+1)+N)%N][((j-1)+N)%N];
-			d  = old_gen[((i+1)+N)%N][((j)+N)%N];
-			dr = old_gen[((i+1)+N)%N][((j+1)+N)%N];
-			neighbors = u + ur + ul + l + r + dr + dl + d;
-
-			char cell     = old_gen[i][j];
-			new_gen[i][j] = neighbors == 3 || (neighbors == 2 && cell);
-		}
+			if (cells[i+FRAME][j+FRAME] != 0) fprintf(fp, "%d %d %d\n", i, j, cells[i+FRAME][j+FRAME]);
+	fclose(fp);
+}
+
+
+
+/*Copy the opposite sides of the board in its ghost frame (FRAME cells wide), the only place where the board wraps around*/
+void fillGhosts(char **cells, int N)
+{
+	int i;
+
+	for (i = FRAME; i < N+FRAME; i++){
+		memcpy(&cells[i][0], &cells[i][N], FRAME);					//Left ghost columns are the last ones
+		memcpy(&cells[i][N+FRAME], &cells[i][FRAME], FRAME);		//Right ghost columns are the first ones
+	}
+	for (i = 0; i < FRAME; i++){
+		memcpy(cells[i], cells[i+N], N+2*FRAME);					//Up ghost rows are the last rows (with the corners already in them)
+		memcpy(cells[N+FRAME+i], cells[FRAME+i], N+2*FRAME);		//Down ghost rows are the first ones
+	}
+}
+
+
+
+/*The cells in columns col0..col1-1 of a row evolve, given the rows above and below it. The sum of the three cells of every column is*/
+/*computed once and rolls from cell to cell (left, centre, right), so a cell costs one new column sum instead of eight reads*/
+static void evolveRow(const char *up, const char *mid, const char *down, char *out, int col0, int col1, char rule[2][9])
+{
+	int j, left, centre, right;
+
+	left   = up[col0-1] + mid[col0-1] + down[col0-1];
+	centre = up[col0] + mid[col0] + down[col0];
+	for (j = col0; j < col1; j++){
+		right  = up[j+1] + mid[j+1] + down[j+1];
+		out[j] = rule[(int)mid[j]][left + centre + right - mid[j]];		//Next value from the rule's transition table
+		left   = centre;
+		centre = right;
+	}
+}
+
+
+
+/*The cells evolve - move to next generation (the ghost frame must be filled)*/
+void evolve(char **old_gen, char **new_gen, int N, char rule[2][9])
+{
+	int i;
+
+	for (i = FRAME; i < N+FRAME; i++)
+		evolveRow(old_gen[i-1], old_gen[i], old_gen[i+1], new_gen[i], FRAME, N+FRAME, rule);
+}
+
+
+
+/*The cells move two generations forward in one pass over the board (the ghost frame, two cells wide, must be filled). The middle*/
+/*generation is kept only in 3 rows (ring), one ring row is computed over the whole width of the frame and then the next row of the*/
+/*result, so every row is read from memory once for both generations*/
+void evolveTwice(char **old_gen, char **new_gen, char **ring, int N, char rule[2][9])
+{
+	int i;
+
+	for (i = 1; i < N+2*FRAME-1; i++){
+		evolveRow(old_gen[i-1], old_gen[i], old_gen[i+1], ring[i % 3], 1, N+2*FRAME-1, rule);		//Middle generation, row i
+		if (i >= FRAME+1)																			//Its rows i-2..i are ready
+			evolveRow(ring[(i-2) % 3], ring[(i-1) % 3], ring[i % 3], new_gen[i-1], FRAME, N+FRAME, rule);
 	}
 }
 
@@ -83,42 +144,64 @@ void evolve(char **old_gen, char **new_gen, int N)
 int main(int argc, char const *argv[])
 {
 	int  i, j, q, N, generations;
-	char output = 0;
-	char **cells, **new_gen, **swap;
-	char line[64], *token, delim[2] = " ";
-	FILE *fp = NULL;
+	char output = 0, twice = 0;
+	char **cells, **new_gen, **swap, **ring, rule[2][9], *rulestring = "B3/S23", *dumpfile = NULL;
+	char *inputfile = NULL;
+	mapped input;
+	int  counting = 0, available = 0;
+	long long counts[2][COUNTERS+1] = {{0}};
+	const char *kernels[2] = {"evolve", "fillGhosts"};
 
 	/*Read the arguments*/
 	for (i = 0; i < argc; i++){
 		if (!strcmp(argv[i], "-n")) N = atoi(argv[++i]);
 		else if (!strcmp(argv[i], "-g")) generations = atoi(argv[++i]);
-		else if (!strcmp(argv[i], "-i")) fp = fopen(argv[++i], "r");
+		else if (!strcmp(argv[i], "-i")) inputfile = (char *)argv[++i];
 		else if (!strcmp(argv[i], "-o1")) output = 1;
 		else if (!strcmp(argv[i], "-o2")) output = 2;
+		else if (!strcmp(argv[i], "-r")) rulestring = (char *)argv[++i];
+		else if (!strcmp(argv[i], "-w")) dumpfile = (char *)argv[++i];
+		else if (!strcmp(argv[i], "-2")) twice = 1;
+		else if (!strcmp(argv[i], "-c")) counting = 1;
 	}
 
-	/*Allocate memory for cells and new_gen arrays and initialize them with 0s or randomly*/
-	if (fp == NULL){
+	/*Build the transition table of the rule (Conway's B3/S23 by default), or else exit*/
+	if (parseRule(rulestring, rule) != 0){
+		fprintf(stderr, "Invalid rule %s (B/S notation is expected, e.g. B36/S23)\n", rulestring);
+		return 1;
+	}
+
+	/*Map the input file in memory (if there is one), its lines are scanned straight from the mapping*/
+	if ((inputfile != NULL) && (mapInput(inputfile, &input) != 0)){
+		fprintf(stderr, "Cannot read the input file %s\n", inputfile);
+		return 1;
+	}
+
+	/*Allocate memory for cells and new_gen arrays and initialize them with 0s or randomly, with the ghost frame around them*/
+	if (inputfile == NULL){
 		srand(time(NULL));
-		cells = allocateArray(N, 1);
+		cells = allocateArray(N+2*FRAME, N+2*FRAME, 1);
 	}
-	else cells = allocateArray(N, 0);
-	new_gen = allocateArray(N, 0);
+	else cells = allocateArray(N+2*FRAME, N+2*FRAME, 0);
+	new_gen = allocateArray(N+2*FRAME, N+2*FRAME, 0);
+	ring    = allocateArray(3, N+2*FRAME, 0);			//The 3 rows of the middle generation of -2
 
 	/*Read from input file the position of initial live cells (if there is input file)*/
-	if (fp != NULL){
-		fgets(line, 64, fp);
-		while (!feof(fp)){
-			token = strtok(line, delim);
-			i = atoi(token);
-			token = strtok(NULL, delim);
-			j = atoi(token);
-			cells[i][j] = 1;
-			fgets(line, 64, fp);
+	if (inputfile != NULL){
+		while (nextCoordinates(&input, &i, &j)){
+			if ((i < 0) || (j < 0) || (i >= N) || (j >= N)){
+				fprintf(stderr, "The cell %d %d of %s is out of the %d x %d board\n", i, j, inputfile, N, N);
+				return 1;
+			}
+			cells[i+FRAME][j+FRAME] = 1;
 		}
-		fclose(fp);
+		unmapInput(&input);
 	}
 
+	/*Hardware counters around the kernel and the filling of the ghost frame (-c)*/
+	if (twice && (output != 2)) kernels[0] = "evolveTwice";
+	if (counting) available = countersOpen();
+
 	clock_t start = clock();							//Begin counting time
 
 	/*Calculate every generation and print it*/
@@ -127,16 +210,33 @@ int main(int argc, char const *argv[])
 		if (output == 2) show(cells, N);		//Print the cells array in every generation if told so in command line (-o2)
 
 		if (q != generations-1){
-			evolve(cells, new_gen, N);
+			if (counting) countersStart();
+			fillGhosts(cells, N);
+			if (counting){
+				countersStop(counts[1], (long long)N*N);
+				countersStart();
+			}
+			if (twice && (output != 2) && (q+1 != generations-1)){
+				evolveTwice(cells, new_gen, ring, N, rule);			//Two generations in one pass (-2), unless every one is printed
+				q++;
+				if (counting) countersStop(counts[0], 2LL*N*N);
+			}
+			else {
+				evolve(cells, new_gen, N, rule);
+				if (counting) countersStop(counts[0], (long long)N*N);
+			}
 			swap    = cells;
 			cells   = new_gen;
 			new_gen = swap;
 		}
 	}
 	if (output == 1) show(cells, N);			//Print the cells array only at the end (-o1)
+	if (dumpfile != NULL) dump(cells, N, (generations > 0) ? generations-1 : 0, dumpfile);		//Write them in a file (-w)
 
-	deleteArray(cells, N);
-	deleteArray(new_gen, N);
+	deleteArray(cells);
+	deleteArray(new_gen);
+	deleteArray(ring);
+	emptyPool();					//Return the buffers of the pool to the system
 
 	/*Finish counting time, print it*/
 	clock_t finish = clock();
@@ -145,6 +245,10 @@ int main(int argc, char const *argv[])
 	printf("--------------------------------------------------------------\n");
 	printf("Runtime %f \n", alltime);
 	printf("--------------------------------------------------------------\n");
+	if (counting){
+		countersShow(counts, kernels, 2, available);
+		countersClose();
+	}
 
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,12 @@
+#ifndef __halo__
+#define __halo__
+
+#include "mpi.h"
+
+
+void createHaloTypes(int n, int r, MPI_Datatype types[3]);
+void freeHaloTypes(MPI_Datatype types[3]);
+void exchangeHalo(char **pad, int n, int r, int neighbours[8], MPI_Datatype types[3], MPI_Comm comm, MPI_Request request[16]);
+
+
+#endif
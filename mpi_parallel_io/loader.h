@@ -0,0 +1,21 @@
+#ifndef __loader__
+#define __loader__
+
+#include <stddef.h>
+
+
+/*An input file mapped in memory, scanned from next up to stop (a part of it, or all of it)*/
+typedef struct {
+	char   *text;
+	size_t length, next, stop;
+} mapped;
+
+
+int  mapInput(const char *filename, mapped *input);
+void unmapInput(mapped *input);
+void splitInput(mapped *input, int part, int parts);
+int  nextCoordinates(mapped *input, int *i, int *j);
+int  readGrid(const mapped *input, int N, int row0, int col0, int rows, int cols, char **block, int offset);
+
+
+#endif
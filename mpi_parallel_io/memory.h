@@ -0,0 +1,16 @@
+#ifndef __memory__
+#define __memory__
+
+#include <stddef.h>
+
+#define CELL_ALIGN     64						//Alignment of every buffer (a cache line, as wide as the widest vector register)
+#define HUGE_PAGE      ((size_t)2 << 20)		//Size of a huge page (2 MiB on x86-64)
+#define HUGE_THRESHOLD (4*HUGE_PAGE)			//Buffers at least this large are backed by huge pages
+
+
+void *allocateCells(size_t bytes);
+void releaseCells(void *p);
+void emptyPool(void);
+
+
+#endif
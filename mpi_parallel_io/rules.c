@@ -0,0 +1,26 @@
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+
+
+
+/*Build the transition table of a Life-like rule given as a B/S rulestring (e.g. B3/S23, B36/S23, B2/S)*/
+int parseRule(const char *rulestring, char rule[2][9])
+{
+	int  i, state;
+	const char *p;
+
+	memset(rule, 0, 2*9*sizeof(char));			//Every cell dies or stays dead, unless the rulestring says otherwise
+	state = -1;
+	for (p = rulestring; *p != '\0'; p++){
+		if ((*p == 'B') || (*p == 'b')) state = 0;				//Birth digits follow (dead cell becomes alive)
+		else if ((*p == 'S') || (*p == 's')) state = 1;			//Survival digits follow (live cell stays alive)
+		else if (*p == '/') state = -1;
+		else if ((state != -1) && isdigit((unsigned char)*p) && (*p != '9')){
+			i = *p - '0';
+			rule[state][i] = 1;					//rule[cell][neighbours] is the value of the cell in the next generation
+		}
+		else return -1;							//Not a B/S rulestring
+	}
+	return 0;
+}
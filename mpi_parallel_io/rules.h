@@ -0,0 +1,8 @@
+#ifndef __rules__
+#define __rules__
+
+
+int parseRule(const char *rulestring, char rule[2][9]);
+
+
+#endif
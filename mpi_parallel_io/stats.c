@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include "mpi.h"
+#include "stats.h"
+
+
+/*The fields of a generation, as they are reduced: sums first, then the minimums and the maximums of the bounding box*/
+enum {STATS_POPULATION, STATS_BIRTHS, STATS_DEATHS, STATS_TOP, STATS_LEFT, STATS_BOTTOM, STATS_RIGHT};
+
+int statistics = 0;						//Set by statsStart() (-S in cmd)
+
+static FILE *fp;
+static MPI_Comm communicator;
+static MPI_Datatype recordtype;
+static MPI_Op  combine;
+static MPI_Request request = MPI_REQUEST_NULL;
+static int  rank, count, pending, first[2], current;
+static long long *local[2], *all[2];		//Two batches, one is reduced while the other is filled
+
+
+
+/*The reduction of the records of a batch: the counts are added, the bounding boxes are joined*/
+static void combineRecords(void *in, void *inout, int *length, MPI_Datatype *type)
+{
+	int  k;
+	long long *a = in, *b = inout;
+
+	(void)type;
+	for (k = 0; k < *length; k++, a += STATS_FIELDS, b += STATS_FIELDS){
+		b[STATS_POPULATION] += a[STATS_POPULATION];
+		b[STATS_BIRTHS]     += a[STATS_BIRTHS];
+		b[STATS_DEATHS]     += a[STATS_DEATHS];
+		if (a[STATS_TOP] < b[STATS_TOP]) b[STATS_TOP] = a[STATS_TOP];
+		if (a[STATS_LEFT] < b[STATS_LEFT]) b[STATS_LEFT] = a[STATS_LEFT];
+		if (a[STATS_BOTTOM] > b[STATS_BOTTOM]) b[STATS_BOTTOM] = a[STATS_BOTTOM];
+		if (a[STATS_RIGHT] > b[STATS_RIGHT]) b[STATS_RIGHT] = a[STATS_RIGHT];
+	}
+}
+
+
+
+/*Start keeping the statistics, only the main process writes them (as CSV), returns -1 there if the file cannot be written*/
+int statsStart(const char *filename, int my_rank, MPI_Comm comm)
+{
+	int  k;
+
+	rank         = my_rank;
+	communicator = comm;
+	if (rank == 0){
+		if ((fp = fopen(filename, "w")) == NULL) return -1;
+		fprintf(fp, "generation,population,births,deaths,top,left,bottom,right\n");
+	}
+	for (k = 0; k < 2; k++){
+		local[k] = malloc(STATS_BATCH*STATS_FIELDS * sizeof(long long));
+		all[k]   = (rank == 0) ? malloc(STATS_BATCH*STATS_FIELDS * sizeof(long long)) : NULL;
+	}
+	MPI_Type_contiguous(STATS_FIELDS, MPI_LONG_LONG, &recordtype);
+	MPI_Type_commit(&recordtype);
+	MPI_Op_create(combineRecords, 1, &combine);
+	count      = 0;
+	pending    = 0;
+	current    = 0;
+	statistics = 1;
+	return 0;
+}
+
+
+
+/*Wait for the batch in flight and write its generations (an empty board has the bounding box -1,-1,-1,-1)*/
+static void writePending(void)
+{
+	int  k, other = 1 - current;
+	long long *r;
+
+	MPI_Wait(&request, MPI_STATUS_IGNORE);
+	if (rank == 0){
+		for (k = 0; k < pending; k++){
+			r = all[other] + k*STATS_FIELDS;
+			if (r[STATS_BOTTOM] < 0) r[STATS_TOP] = r[STATS_LEFT] = r[STATS_RIGHT] = -1;
+			fprintf(fp, "%d,%lld,%lld,%lld,%lld,%lld,%lld,%lld\n", first[other] + k, r[STATS_POPULATION], r[STATS_BIRTHS], r[STATS_DEATHS],
+					r[STATS_TOP], r[STATS_LEFT], r[STATS_BOTTOM], r[STATS_RIGHT]);
+		}
+	}
+	pending = 0;
+}
+
+
+
+/*Reduce the batch that is filled while the next one is filled (the previous reduction is over by then, since it had a whole batch of*/
+/*generations to finish)*/
+static void flush(void)
+{
+	writePending();
+	MPI_Ireduce(local[current], all[current], count, recordtype, combine, 0, communicator, &request);
+	pending = count;
+	count   = 0;
+	current = 1 - current;
+}
+
+
+
+/*Keep the statistics of the block of this process for a generation, row 0 and column 0 of its padded array are row0 and col0 of*/
+/*the board (in the ghost frame, before the first cell of the block). Every process calls it for the same generations*/
+void statsRecord(int generation, const gol_stats *block, int row0, int col0)
+{
+	long long *r = local[current] + count*STATS_FIELDS;
+
+	if (count == 0) first[current] = generation;
+	r[STATS_POPULATION] = block->population;
+	r[STATS_BIRTHS]     = block->births;
+	r[STATS_DEATHS]     = block->deaths;
+	r[STATS_TOP]        = (block->bottom < 0) ? LLONG_MAX : row0 + block->top;
+	r[STATS_LEFT]       = (block->bottom < 0) ? LLONG_MAX : col0 + block->left;
+	r[STATS_BOTTOM]     = (block->bottom < 0) ? -1 : row0 + block->bottom;
+	r[STATS_RIGHT]      = (block->bottom < 0) ? -1 : col0 + block->right;
+	if (++count == STATS_BATCH) flush();
+}
+
+
+
+/*Reduce and write the generations that are left*/
+void statsFinish(void)
+{
+	int k;
+
+	if (!statistics) return;
+	if (count > 0) flush();
+	writePending();
+	if (rank == 0) fclose(fp);
+	for (k = 0; k < 2; k++){
+		free(local[k]);
+		free(all[k]);
+	}
+	MPI_Op_free(&combine);
+	MPI_Type_free(&recordtype);
+	statistics = 0;
+}
@@ -0,0 +1,20 @@
+#ifndef __stats__
+#define __stats__
+
+#include "mpi.h"
+#include "gol.h"
+
+
+/*Statistics of every generation (-S in cmd): the live cells, births and deaths and the bounding box of the live cells in the board*/
+#define STATS_FIELDS 7
+#define STATS_BATCH  1024				//Generations reduced together (with one MPI_Ireduce) and written to the file
+
+extern int statistics;
+
+
+int  statsStart(const char *filename, int my_rank, MPI_Comm comm);
+void statsRecord(int generation, const gol_stats *block, int row0, int col0);
+void statsFinish(void);
+
+
+#endif
@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "tiles.h"
+#include "tileread.h"
+
+
+
+/*Copy a rows x cols block, starting at cell (row0, col0), of an N x N tiled file (tiles T x T) in block[offset..][offset..]*/
+/*Only the tiles over the block are read: for every row of them, one collective read of their offsets in the index and one of the*/
+/*tiles (they are one after the other in the file). Every process of comm must call it, returns -1 if the file cannot be read*/
+int readTiles(const char *filename, int N, int T, int row0, int col0, int rows, int cols, char **block, int offset, MPI_Comm comm)
+{
+	int  b, c, i, j, tiles = tilesPerSide(N, T), error = 0, count, most;
+	int  tr0 = row0 / T, tc0 = col0 / T, bands = (row0 + rows-1) / T - tr0 + 1, span = (col0 + cols-1) / T - tc0 + 1;
+	int  R, C, i0, i1, j0, j1;
+	uint64_t first, start, end;
+	size_t size = 0;
+	unsigned char *index = malloc(8*(span+1)), *bits = malloc((size_t)T*T/8), *data = NULL;
+	MPI_File fp;
+	MPI_Status status;
+
+	if (MPI_File_open(comm, (char *)filename, MPI_MODE_RDONLY, MPI_INFO_NULL, &fp) != MPI_SUCCESS){
+		free(index);
+		free(bits);
+		return -1;
+	}
+
+	/*Every process reads as many times as the one with the most rows of tiles (reading nothing in the end, if it has fewer)*/
+	MPI_Allreduce(&bands, &most, 1, MPI_INT, MPI_MAX, comm);
+	for (b = 0; b < most; b++){
+		count = (b < bands) ? 8*(span+1) : 0;
+		MPI_File_read_at_all(fp, indexOffset((size_t)(tr0+b)*tiles + tc0), index, count, MPI_BYTE, &status);
+		first = count ? get64(index) : 0;
+		end   = count ? get64(index + 8*span) : 0;
+		if (end < first){
+			error = 1;
+			end   = first;
+		}
+		if (end - first > size){
+			size = end - first;
+			data = realloc(data, size);
+		}
+		MPI_File_read_at_all(fp, first, data, (int)(end - first), MPI_BYTE, &status);
+		if (count == 0) continue;
+
+		/*Decompress every tile and copy the cells of it that are in the block*/
+		R  = (tr0+b) * T;
+		i0 = (R > row0) ? R : row0;
+		i1 = (R+T < row0+rows) ? R+T : row0+rows;
+		for (c = 0; c < span; c++){
+			C     = (tc0+c) * T;
+			start = get64(index + 8*c);
+			end   = get64(index + 8*(c+1));
+			if ((start < first) || (end < start) || (end - first > size) || (decodeTile(data + (start - first), end - start, bits, T) != 0)){
+				error = 1;
+				continue;
+			}
+			j0 = (C > col0) ? C : col0;
+			j1 = (C+T < col0+cols) ? C+T : col0+cols;
+			for (i = i0; i < i1; i++)
+				for (j = j0; j < j1; j++)
+					block[i-row0+offset][j-col0+offset] = (bits[(size_t)(i-R)*(T/8) + (j-C)/8] >> ((j-C)%8)) & 1;
+		}
+	}
+
+	MPI_File_close(&fp);
+	free(index);
+	free(bits);
+	free(data);
+	return error ? -1 : 0;
+}
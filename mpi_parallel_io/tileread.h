@@ -0,0 +1,10 @@
+#ifndef __tileread__
+#define __tileread__
+
+#include "mpi.h"
+
+
+int readTiles(const char *filename, int N, int T, int row0, int col0, int rows, int cols, char **block, int offset, MPI_Comm comm);
+
+
+#endif
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tiles.h"
+
+
+static const char magic[8] = {'G', 'O', 'L', 'T', 'I', 'L', 'E', '1'};
+
+
+
+/*Tiles in each row (and column) of tiles of the board*/
+int tilesPerSide(int N, int T)
+{
+	return (N + T-1) / T;
+}
+
+
+
+/*Most bytes a compressed tile can take (the kind and the raw packed cells)*/
+size_t tileBound(int T)
+{
+	return 1 + (size_t)T*T/8;
+}
+
+
+
+/*Place in the file of the offset of a tile (the offset of tile tiles*tiles is the end of the file)*/
+size_t indexOffset(size_t tile)
+{
+	return TILE_HEADER + 8*tile;
+}
+
+
+
+void put64(unsigned char *out, uint64_t value)
+{
+	int k;
+
+	for (k = 0; k < 8; k++)
+		out[k] = (unsigned char)(value >> (8*k));
+}
+
+
+
+uint64_t get64(const unsigned char *in)
+{
+	int  k;
+	uint64_t value = 0;
+
+	for (k = 0; k < 8; k++)
+		value |= (uint64_t)in[k] << (8*k);
+	return value;
+}
+
+
+
+static void put32(unsigned char *out, uint32_t value)
+{
+	int k;
+
+	for (k = 0; k < 4; k++)
+		out[k] = (unsigned char)(value >> (8*k));
+}
+
+
+
+static uint32_t get32(const unsigned char *in)
+{
+	return in[0] | (in[1] << 8) | (in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+
+
+void writeTileHeader(unsigned char *header, int N, int T)
+{
+	memcpy(header, magic, 8);
+	put32(header + 8, N);
+	put32(header + 12, T);
+}
+
+
+
+/*Read the header of a tiled file, returns -1 if it is not one (e.g. a grid file)*/
+int readTileHeader(const unsigned char *header, size_t length, int *N, int *T)
+{
+	if ((length < TILE_HEADER) || memcmp(header, magic, 8)) return -1;
+	*N = get32(header + 8);
+	*T = get32(header + 12);
+	if ((*N < 1) || (*T < 8) || (*T % 8 != 0)) return -1;
+	return 0;
+}
+
+
+
+/*Compress a packed T x T tile (rows stride bytes apart) in out (at most tileBound() bytes), returns its length (0 if it is empty)*/
+size_t encodeTile(unsigned char *out, const unsigned char *bits, size_t stride, int T)
+{
+	int  i, j, row = T/8, zeros = 1, ones = 1;
+	size_t length = 1, raw = tileBound(T);
+	unsigned char byte, value = bits[0], run = 0;
+
+	for (i = 0; i < T; i++){
+		for (j = 0; j < row; j++){
+			zeros &= (bits[i*stride + j] == 0x00);
+			ones  &= (bits[i*stride + j] == 0xFF);
+		}
+	}
+	if (zeros) return 0;
+	if (ones){
+		out[0] = TILE_ONES;
+		return 1;
+	}
+
+	/*Runs of the same byte, given up as soon as they would take as many bytes as the raw tile*/
+	out[0] = TILE_RLE;
+	for (i = 0; (i < T) && (length + 2 < raw); i++){
+		for (j = 0; (j < row) && (length + 2 < raw); j++){
+			byte = bits[i*stride + j];
+			if ((byte == value) && (run < 255)) run++;
+			else {
+				out[length++] = run;
+				out[length++] = value;
+				value = byte;
+				run   = 1;
+			}
+		}
+	}
+	if (length + 2 < raw){
+		out[length++] = run;
+		out[length++] = value;
+		return length;
+	}
+
+	out[0] = TILE_RAW;
+	for (i = 0; i < T; i++)
+		memcpy(out + 1 + (size_t)i*row, bits + i*stride, row);
+	return raw;
+}
+
+
+
+/*Decompress a tile in bits (T x T/8 bytes), returns -1 if the tile is damaged*/
+int decodeTile(const unsigned char *in, size_t length, unsigned char *bits, int T)
+{
+	size_t k, filled = 0, size = (size_t)T*T/8;
+
+	if (length == 0){
+		memset(bits, 0x00, size);
+		return 0;
+	}
+	switch (in[0]){
+		case TILE_ONES:
+			memset(bits, 0xFF, size);
+			return 0;
+		case TILE_RAW:
+			if (length != size+1) return -1;
+			memcpy(bits, in + 1, size);
+			return 0;
+		case TILE_RLE:
+			for (k = 1; k+1 < length; k += 2){
+				if (filled + in[k] > size) return -1;
+				memset(bits + filled, in[k+1], in[k]);
+				filled += in[k];
+			}
+			return (filled == size) ? 0 : -1;
+	}
+	return -1;
+}
@@ -0,0 +1,33 @@
+#ifndef __tiles__
+#define __tiles__
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/*Tiled board file: a header, an index of offsets and the tiles one after the other (row by row of tiles)*/
+/*  bytes 0-7   "GOLTILE1"*/
+/*  bytes 8-15  side of the board and side of the tiles (32 bit each, little endian)*/
+/*  index       tiles+1 offsets from the start of the file (64 bit each, little endian), tile k is between offsets k and k+1*/
+/*Every tile is bit packed (T/8 bytes per row, cell j in bit j%8 of byte j/8, the cells out of the board are 0) and compressed*/
+#define TILE_HEADER 16
+#define TILE_SIDE   256				//Default side of the tiles (a multiple of 8)
+
+/*Kinds of tiles, in the first byte (an empty tile takes no bytes at all)*/
+#define TILE_ONES 1					//All cells alive
+#define TILE_RLE  2					//Pairs of bytes (run 1..255, value)
+#define TILE_RAW  3					//The packed bytes as they are
+
+
+int     tilesPerSide(int N, int T);
+size_t  tileBound(int T);
+size_t  indexOffset(size_t tile);
+void    writeTileHeader(unsigned char *header, int N, int T);
+int     readTileHeader(const unsigned char *header, size_t length, int *N, int *T);
+void    put64(unsigned char *out, uint64_t value);
+uint64_t get64(const unsigned char *in);
+size_t  encodeTile(unsigned char *out, const unsigned char *bits, size_t stride, int T);
+int     decodeTile(const unsigned char *in, size_t length, unsigned char *bits, int T);
+
+
+#endif
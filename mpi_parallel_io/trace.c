@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mpi.h"
+#include "trace.h"
+
+
+/*One timed phase of one generation in one process*/
+typedef struct {
+	int    phase, generation;
+	double start, end;
+} event;
+
+int tracing = 0;						//Set by traceStart() (-T in cmd)
+
+static const char *names[TRACE_PHASES] = {"halo post", "evolve_inner", "MPI_Waitall", "evolve_sides", "reductions", "gather/output"};
+static const char *file;
+static event  *events;
+static int    count, allocated;
+static double zero;
+
+
+
+/*Start keeping the phases of every generation, the times are written relative to origin (the start of the timer after the barrier)*/
+void traceStart(const char *filename, int generations, double origin)
+{
+	file      = filename;
+	allocated = (generations + 1) * TRACE_PHASES;
+	events    = malloc(allocated * sizeof(event));
+	count     = 0;
+	zero      = origin;
+	tracing   = 1;
+}
+
+
+
+/*Keep the phase that lasted from since until now and return now (the start of the next phase)*/
+double tracePhase(int phase, int generation, double since)
+{
+	double now = MPI_Wtime();
+
+	if (count == allocated){
+		allocated *= 2;
+		events = realloc(events, allocated * sizeof(event));
+	}
+	events[count].phase      = phase;
+	events[count].generation = generation;
+	events[count].start      = since - zero;
+	events[count].end        = now - zero;
+	count++;
+	return now;
+}
+
+
+
+/*Write the phases of all processes as a Chrome trace (chrome://tracing, Perfetto) or as CSV if the file ends in .csv*/
+static void writeTrace(event *all, int *counts, int processes)
+{
+	int  p, k, n, first = 1;
+	size_t length = strlen(file);
+	int  csv = (length >= 4) && !strcmp(file + length - 4, ".csv");
+	FILE *fp = fopen(file, "w");
+
+	if (fp == NULL){
+		fprintf(stderr, "Cannot write the trace in %s\n", file);
+		return;
+	}
+	if (csv) fprintf(fp, "rank,generation,phase,start,end,duration\n");
+	else fprintf(fp, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	for (p = 0, n = 0; p < processes; p++){
+		if (!csv){
+			fprintf(fp, "%s{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %d, \"tid\": 0, \"args\": {\"name\": \"rank %d\"}}", first ? "" : ",\n", p, p);
+			first = 0;
+		}
+		for (k = 0; k < counts[p]; k++, n++){
+			if (csv) fprintf(fp, "%d,%d,%s,%.9f,%.9f,%.9f\n", p, all[n].generation, names[all[n].phase], all[n].start, all[n].end, all[n].end - all[n].start);
+			else fprintf(fp, ",\n{\"name\": \"%s\", \"ph\": \"X\", \"pid\": %d, \"tid\": 0, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"generation\": %d}}",
+						 names[all[n].phase], p, 1e6*all[n].start, 1e6*(all[n].end - all[n].start), all[n].generation);
+		}
+	}
+	if (!csv) fprintf(fp, "\n]}\n");
+	fclose(fp);
+}
+
+
+
+/*Gather the phases of all processes in the main one, which writes them in the file and prints the time of each phase*/
+void traceFinish(MPI_Comm comm, int my_rank, int processes)
+{
+	int  p, k, *counts = NULL, *bytes = NULL, *displacements = NULL;
+	double total[TRACE_PHASES], maxtime[TRACE_PHASES], mintime[TRACE_PHASES], sumtime[TRACE_PHASES];
+	event *all = NULL;
+
+	if (!tracing) return;
+
+	/*Time of each phase in this process over all generations*/
+	for (p = 0; p < TRACE_PHASES; p++)
+		total[p] = 0.0;
+	for (k = 0; k < count; k++)
+		total[events[k].phase] += events[k].end - events[k].start;
+	MPI_Reduce(total, maxtime, TRACE_PHASES, MPI_DOUBLE, MPI_MAX, 0, comm);
+	MPI_Reduce(total, mintime, TRACE_PHASES, MPI_DOUBLE, MPI_MIN, 0, comm);
+	MPI_Reduce(total, sumtime, TRACE_PHASES, MPI_DOUBLE, MPI_SUM, 0, comm);
+
+	/*The events travel as bytes, since they are only written by the main process*/
+	if (my_rank == 0){
+		counts        = malloc(processes * sizeof(int));
+		bytes         = malloc(processes * sizeof(int));
+		displacements = malloc(processes * sizeof(int));
+	}
+	MPI_Gather(&count, 1, MPI_INT, counts, 1, MPI_INT, 0, comm);
+	if (my_rank == 0){
+		for (p = 0, k = 0; p < processes; p++){
+			bytes[p]         = counts[p] * sizeof(event);
+			displacements[p] = k;
+			k += bytes[p];
+		}
+		all = malloc(k);
+	}
+	MPI_Gatherv(events, count * sizeof(event), MPI_BYTE, all, bytes, displacements, MPI_BYTE, 0, comm);
+
+	if (my_rank == 0){
+		writeTrace(all, counts, processes);
+		printf("Phase               Maximum      Minimum      Average\n");
+		for (p = 0; p < TRACE_PHASES; p++)
+			if (maxtime[p] > 0.0)
+				printf("%-16s %12f %12f %12f\n", names[p], maxtime[p], mintime[p], sumtime[p]/processes);
+		printf("--------------------------------------------------------------\n");
+		free(counts);
+		free(bytes);
+		free(displacements);
+		free(all);
+	}
+	free(events);
+	tracing = 0;
+}
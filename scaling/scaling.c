@@ -0,0 +1,291 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+
+#define BUFSIZE   1024
+#define MAX_LIST  16
+#define MAX_RUNS  4096
+
+
+/*An engine is an MPI program of the other folders that prints its Maximum, Minimum and Average Runtime*/
+typedef struct {
+	const char *name;				//Path from the top folder (the program is ../name)
+	int  threads;					//It takes the threads of every process with -t
+	int  grid;						//It needs an input file as a grid (mpi_parallel_io), the others start from a random board
+} engine;
+
+static engine engines[] = {
+	{"mpi/gol-mpi",                         0, 0},
+	{"mpi_omp/gol-mpi_omp",                 1, 0},
+	{"mpi_parallel_io/gol-mpi_parallel_io", 0, 1},
+};
+
+/*One run of an engine, the times are -1 if it did not finish*/
+typedef struct {
+	int    engine, N, generations, processes, threads;
+	double max, min, avg;
+	double speedup, efficiency, karpflatt;
+} result;
+
+static char directory[] = "/tmp/gol-scaling-XXXXXX";
+static const char *launcher = "mpiexec";
+
+
+
+/*Read a list of numbers separated by commas (e.g. 1,4,9,16), returns how many there are*/
+int readList(const char *text, int list[MAX_LIST])
+{
+	int  count = 0;
+	const char *p = text;
+
+	while ((*p != '\0') && (count < MAX_LIST)){
+		list[count++] = atoi(p);
+		p = strchr(p, ',');
+		if (p == NULL) break;
+		p++;
+	}
+	return count;
+}
+
+
+
+/*Run an engine and read the runtimes it prints (returns -1 if there are none, e.g. the program failed)*/
+int run(result *r, unsigned int seed)
+{
+	char command[4*BUFSIZE], options[BUFSIZE] = "", line[BUFSIZE];
+	engine *e = &engines[r->engine];
+	int  found = 0;
+	FILE *pp;
+
+	if (e->threads) sprintf(options, "-t %d", r->threads);
+	if (e->grid){
+		/*The same board for every run of this size (tiled, so that even large ones are written fast)*/
+		sprintf(options, "-i '%s/board%d'", directory, r->N);
+		sprintf(command, "%s/board%d", directory, r->N);
+		if (access(command, R_OK) != 0){
+			sprintf(command, "../mpi_parallel_io/create_file -n %d -d 50 -s %u -F tiles -f '%s/board%d' > /dev/null 2>&1", r->N, seed, directory, r->N);
+			if (system(command) != 0) return -1;
+		}
+	}
+	sprintf(command, "%s -n %d ../%s -n %d -g %d %s 2>/dev/null", launcher, r->processes, e->name, r->N, r->generations, options);
+
+	r->max = r->min = r->avg = -1;
+	pp = popen(command, "r");
+	if (pp == NULL) return -1;
+	while (fgets(line, BUFSIZE, pp) != NULL){
+		found += (sscanf(line, "Maximum Runtime = %lf", &r->max) == 1);
+		found += (sscanf(line, "Minimum Runtime = %lf", &r->min) == 1);
+		found += (sscanf(line, "Average Runtime = %lf", &r->avg) == 1);
+	}
+	pclose(pp);
+	return (found == 3) ? 0 : -1;
+}
+
+
+
+/*The side that groups the runs: the side of the board with strong scaling, the side of the block of every process with weak scaling*/
+int groupSide(const result *r, int weak)
+{
+	return weak ? r->N / (int)sqrt((double)r->processes) : r->N;
+}
+
+
+
+/*Two runs are in the same group if they have the same engine, side (or side of the blocks) and generations. With weak scaling the*/
+/*board grows only with the processes, so the runs of gol-mpi_omp are compared only with the ones that have the same threads*/
+int sameGroup(const result *a, const result *b, int weak)
+{
+	if ((a->engine != b->engine) || (a->generations != b->generations) || (groupSide(a, weak) != groupSide(b, weak))) return 0;
+	return !weak || (a->threads == b->threads);
+}
+
+
+
+/*Speedup, efficiency and Karp-Flatt metric of every run against the run of its group with the fewest cores. With strong scaling*/
+/*S = c0*T(c0)/T(p) and the Karp-Flatt metric e = (1/S - 1/p) / (1 - 1/p) is the serial fraction the speedup shows. With weak scaling*/
+/*the efficiency is T(c0)/T(p) and S = E*p, without Karp-Flatt, which holds only for a board of fixed size*/
+void metrics(result *runs, int nruns, int weak)
+{
+	int  k, m, base, p, c0;
+	double S;
+
+	for (k = 0; k < nruns; k++){
+		runs[k].speedup = runs[k].efficiency = runs[k].karpflatt = -1;
+		if (runs[k].max <= 0) continue;
+		base = -1;
+		for (m = 0; m < nruns; m++){
+			if (!sameGroup(&runs[m], &runs[k], weak) || (runs[m].max <= 0)) continue;
+			if ((base < 0) || (runs[m].processes*runs[m].threads < runs[base].processes*runs[base].threads)) base = m;
+		}
+		p  = runs[k].processes * runs[k].threads;
+		c0 = runs[base].processes * runs[base].threads;
+		if (weak){
+			runs[k].efficiency = runs[base].max / runs[k].max;
+			runs[k].speedup    = runs[k].efficiency * p;
+			continue;
+		}
+		S = c0 * runs[base].max / runs[k].max;
+		runs[k].efficiency = S / p;
+		runs[k].speedup    = S;
+		if (p > 1) runs[k].karpflatt = (1/S - 1.0/p) / (1 - 1.0/p);
+	}
+}
+
+
+
+/*Write the runs in a csv file and a gnuplot script that draws the speedup and the efficiency of every group in svg files*/
+int writeResults(const char *prefix, result *runs, int nruns, int weak)
+{
+	int  i, k, m, first, side;
+	char filename[BUFSIZE], threads[32], label[32];
+	FILE *fp;
+
+	sprintf(filename, "%s.csv", prefix);
+	if ((fp = fopen(filename, "w")) == NULL) return -1;
+	fprintf(fp, "engine,scaling,n,block,generations,processes,threads,cores,max,min,avg,speedup,efficiency,karpflatt\n");
+	for (k = 0; k < nruns; k++){
+		side = (int)sqrt((double)runs[k].processes);
+		fprintf(fp, "%s,%s,%d,%d,%d,%d,%d,%d,%f,%f,%f,%f,%f,%f\n", engines[runs[k].engine].name, weak ? "weak" : "strong",
+				runs[k].N, runs[k].N / side, runs[k].generations, runs[k].processes, runs[k].threads, runs[k].processes*runs[k].threads,
+				runs[k].max, runs[k].min, runs[k].avg, runs[k].speedup, runs[k].efficiency, runs[k].karpflatt);
+	}
+	fclose(fp);
+
+	/*One line for every group (engine, side or block, generations and with weak scaling threads) in each plot: gnuplot prefix.gp*/
+	/*writes prefix-speedup.svg and prefix-efficiency.svg*/
+	sprintf(filename, "%s.gp", prefix);
+	if ((fp = fopen(filename, "w")) == NULL) return -1;
+	fprintf(fp, "set datafile separator ','\nset terminal svg size 800,600\nset key left top\nset xlabel 'cores'\nset grid\n");
+	for (m = 0; m < 2; m++){
+		fprintf(fp, "\nset output '%s-%s.svg'\nset ylabel '%s'\nplot ", prefix, m ? "efficiency" : "speedup", m ? "efficiency" : "speedup");
+		if (m == 0) fprintf(fp, "x title 'ideal' dashtype 2, ");
+		else fprintf(fp, "1 title 'ideal' dashtype 2, ");
+		first = 1;
+		for (k = 0; k < nruns; k++){
+			for (i = 0; (i < k) && !sameGroup(&runs[i], &runs[k], weak); i++);
+			if (i < k) continue;							//The group is already drawn
+			if (weak && engines[runs[k].engine].threads){
+				sprintf(threads, " && $7 == %d", runs[k].threads);
+				sprintf(label, " t=%d", runs[k].threads);
+			}
+			else threads[0] = label[0] = '\0';
+			fprintf(fp, "%s\\\n\t'%s.csv' using (strcol(1) eq '%s' && $%d == %d && $5 == %d%s ? $8 : NaN):%d title '%s %s=%d g=%d%s' with linespoints",
+					first ? "" : ", ", prefix, engines[runs[k].engine].name, weak ? 4 : 3, groupSide(&runs[k], weak), runs[k].generations,
+					threads, m ? 13 : 12, engines[runs[k].engine].name, weak ? "block" : "n", groupSide(&runs[k], weak), runs[k].generations, label);
+			first = 0;
+		}
+		fprintf(fp, "\n");
+	}
+	fclose(fp);
+	return 0;
+}
+
+
+
+/*Scaling study - In command line (example): ./gol-scaling -n 1024,2048 -g 100 -p 1,4,9,16 -t 1,2,4 -m "mpiexec -f machines"*/
+/*Every engine runs every side, generations, processes (and threads for gol-mpi_omp) k times, the fastest run is kept. With -W the*/
+/*sides are the sides of the block of every process (weak scaling), so the board grows with the processes*/
+int main(int argc, char *argv[])
+{
+	int  i, k, e, n, g, p, t, sizes[MAX_LIST], gens[MAX_LIST], ranks[MAX_LIST], threads[MAX_LIST], nsizes, ngens, nranks, nthreads;
+	int  repeats = 1, weak = 0, nruns = 0, side, failed = 0;
+	unsigned int seed = 1;
+	const char *prefix = "scaling";
+	char command[BUFSIZE];
+	int  nengines = sizeof(engines) / sizeof(engines[0]);
+	result *runs, r;
+
+	nsizes   = readList("1024,2048", sizes);
+	ngens    = readList("100", gens);
+	nranks   = readList("1,4,9,16", ranks);
+	nthreads = readList("1,2,4", threads);
+
+	/*Read the arguments*/
+	for (i = 0; i < argc; i++){
+		if (!strcmp(argv[i], "-n")) nsizes = readList(argv[++i], sizes);
+		else if (!strcmp(argv[i], "-g")) ngens = readList(argv[++i], gens);
+		else if (!strcmp(argv[i], "-p")) nranks = readList(argv[++i], ranks);
+		else if (!strcmp(argv[i], "-t")) nthreads = readList(argv[++i], threads);
+		else if (!strcmp(argv[i], "-k")) repeats = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-s")) seed = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-m")) launcher = argv[++i];
+		else if (!strcmp(argv[i], "-o")) prefix = argv[++i];
+		else if (!strcmp(argv[i], "-W")) weak = 1;
+	}
+	if (repeats < 1){
+		fprintf(stderr, "At least one run is needed\n");
+		return 1;
+	}
+	if (mkdtemp(directory) == NULL){
+		fprintf(stderr, "Cannot create a folder for the boards\n");
+		return 1;
+	}
+	runs = malloc(MAX_RUNS * sizeof(result));
+
+	/*One line for every run, with its times (the fastest of the repeats) or SKIP/FAIL*/
+	printf("%-38s %7s %6s %9s %7s %5s %11s %11s %11s\n", "engine", "n", "g", "processes", "threads", "cores", "max", "min", "avg");
+	for (e = 0; e < nengines; e++){
+		for (n = 0; n < nsizes; n++){
+			for (g = 0; g < ngens; g++){
+				for (p = 0; p < nranks; p++){
+					for (t = 0; t < (engines[e].threads ? nthreads : 1); t++){
+						side = (int)sqrt((double)ranks[p]);
+						r.engine      = e;
+						r.N           = weak ? sizes[n] * side : sizes[n];
+						r.generations = gens[g];
+						r.processes   = ranks[p];
+						r.threads     = engines[e].threads ? threads[t] : 1;
+						printf("%-38s %7d %6d %9d %7d %5d", engines[e].name, r.N, r.generations, r.processes, r.threads, r.processes*r.threads);
+
+						/*The MPI programs need a square number of processes, with blocks of the same size*/
+						if ((side*side != ranks[p]) || (r.N % side != 0)){
+							printf(" SKIP\n");
+							continue;
+						}
+
+						r.max = -1;
+						runs[nruns] = r;
+						for (k = 0; k < repeats; k++){
+							if (run(&r, seed) != 0) break;
+							if ((runs[nruns].max < 0) || (r.max < runs[nruns].max)) runs[nruns] = r;
+						}
+						if (k < repeats){
+							printf(" FAIL\n");
+							runs[nruns].max = runs[nruns].min = runs[nruns].avg = -1;
+							failed++;
+						}
+						else printf(" %11f %11f %11f\n", runs[nruns].max, runs[nruns].min, runs[nruns].avg);
+						fflush(stdout);
+						if (nruns < MAX_RUNS-1) nruns++;
+					}
+				}
+			}
+		}
+	}
+
+	/*The table of the metrics, the csv file and the plots*/
+	metrics(runs, nruns, weak);
+	printf("\n%s scaling (speedup and efficiency against the run with the fewest cores of each engine, %s)\n",
+			weak ? "Weak" : "Strong", weak ? "block, generations and threads" : "side and generations");
+	printf("%-38s %7s %6s %5s %11s %9s %10s %10s\n", "engine", "n", "g", "cores", "max", "speedup", "efficiency", "karp-flatt");
+	for (k = 0; k < nruns; k++){
+		if (runs[k].max <= 0) continue;
+		printf("%-38s %7d %6d %5d %11f %9.3f %10.3f", engines[runs[k].engine].name, runs[k].N, runs[k].generations,
+				runs[k].processes*runs[k].threads, runs[k].max, runs[k].speedup, runs[k].efficiency);
+		if (runs[k].karpflatt != -1) printf(" %10.4f\n", runs[k].karpflatt);
+		else printf(" %10s\n", "-");
+	}
+	if (writeResults(prefix, runs, nruns, weak) != 0){
+		fprintf(stderr, "Cannot write the results %s.csv and %s.gp\n", prefix, prefix);
+		failed++;
+	}
+	else printf("\nResults in %s.csv (plots with: gnuplot %s.gp)\n", prefix, prefix);
+
+	sprintf(command, "rm -rf '%s'", directory);
+	system(command);
+	free(runs);
+	return (failed > 0);
+}
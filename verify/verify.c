@@ -0,0 +1,324 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+
+#define BUFSIZE   1024
+#define MAX_LIST  16
+
+/*Kinds of rules (an engine runs only the kinds it knows)*/
+#define LIFE        1
+#define LTL         2
+#define GENERATIONS 4
+
+
+/*An engine is a program of the other folders that takes -n, -g, -i, -r and writes its last generation with -w*/
+typedef struct {
+	const char *name;				//Path from the top folder (the program is ../name)
+	const char *options;			//Extra options of the engine
+	int  parallel;					//Run by the MPI launcher with every number of processes of -p
+	int  rules;						//Kinds of rules it runs
+	int  grid;						//Input as a full grid of "0 1 ..." (mpi_parallel_io) and not as coordinates
+	int  tiles;						//Tiles per side of every block (-x), the side of the blocks must be a multiple of it
+} engine;
+
+/*mpi/gol-serial is the reference, every other engine must give exactly the same cells*/
+static const char *reference = "mpi/gol-serial";
+
+static engine engines[] = {
+	{"mpi/gol-mpi",                         "",        1, LIFE | LTL | GENERATIONS, 0, 0},
+	{"mpi/gol-mpi",                         "-x 2",    1, LIFE,                     0, 2},
+	{"mpi_omp/gol-serial",                  "",        0, LIFE,                     0, 0},
+	{"mpi_omp/gol-mpi_omp",                 "-t 2",    1, LIFE,                     0, 0},
+	{"mpi_omp/gol-mpi_omp",                 "-t 2 -l", 1, LIFE,                     0, 0},
+	{"mpi_parallel_io/gol-serial",          "",        0, LIFE,                     0, 0},
+	{"mpi_parallel_io/gol-serial",          "-2",      0, LIFE,                     0, 0},
+	{"mpi_parallel_io/gol-mpi_parallel_io", "",        1, LIFE,                     1, 0},
+};
+
+static const char *rules[] = {"B3/S23", "B36/S23", "B2/S", "R2,C0,M1,S3..5,B3..4,NM", "B2/S/C3", "B2/S345/C4"};
+
+/*Patterns of the input files, placed on the same board (they wrap around the sides and the blocks of the processes)*/
+static const char *patterns[] = {"glider", "blinker", "beacon", "boat", "toad", "mixed"};
+
+static const char *boards[] = {"random50", "random20", "glider", "patterns"};
+
+static char directory[] = "/tmp/gol-verify-XXXXXX";
+static const char *launcher = "mpiexec";
+
+
+
+/*Read a list of numbers separated by commas (e.g. 1,4,9,16), returns how many there are*/
+int readList(const char *text, int list[MAX_LIST])
+{
+	int  count = 0;
+	const char *p = text;
+
+	while ((*p != '\0') && (count < MAX_LIST)){
+		list[count++] = atoi(p);
+		p = strchr(p, ',');
+		if (p == NULL) break;
+		p++;
+	}
+	return count;
+}
+
+
+
+/*The kind of a rule, as the programs tell them apart*/
+int ruleKind(const char *rule)
+{
+	if (rule[0] == 'R') return LTL;
+	if ((strchr(rule, 'C') != NULL) || (strchr(rule, 'c') != NULL)) return GENERATIONS;
+	return LIFE;
+}
+
+
+
+/*Place the live cells of an input file on the board, moved by (di, dj) around the torus*/
+void placePattern(char *cells, int N, const char *filename, int di, int dj)
+{
+	int  i, j;
+	char line[64], *token, delim[2] = " ";
+	FILE *fp = fopen(filename, "r");
+
+	if (fp == NULL){
+		fprintf(stderr, "Cannot read the pattern %s\n", filename);
+		return;
+	}
+	fgets(line, 64, fp);
+	while (!feof(fp)){
+		token = strtok(line, delim);
+		i = atoi(token);
+		token = strtok(NULL, delim);
+		j = atoi(token);
+		cells[((i + di) % N)*N + (j + dj) % N] = 1;
+		fgets(line, 64, fp);
+	}
+	fclose(fp);
+}
+
+
+
+/*Create a board and write it in the two input formats: coordinates of the live cells (board.cells) and the grid (board.grid)*/
+int writeBoard(const char *board, int N, unsigned int seed)
+{
+	int  i, j, k, p = sizeof(patterns) / sizeof(patterns[0]);
+	char filename[BUFSIZE], *cells = calloc((size_t)N*N, sizeof(char));
+	FILE *fp, *fg;
+
+	srand(seed);
+	if (!strcmp(board, "random50") || !strcmp(board, "random20")){
+		for (i = 0; i < N*N; i++)
+			cells[i] = ((rand() % 100) < atoi(board + 6));
+	}
+	else if (!strcmp(board, "glider"))
+		placePattern(cells, N, "../mpi/Input Files/glider", N-2, N-2);			//On the corner of the torus
+	else {
+		for (k = 0; k < p; k++){
+			sprintf(filename, "../mpi/Input Files/%s", patterns[k]);
+			placePattern(cells, N, filename, (k*N/p + N-1) % N, (k*N/p + N/2) % N);
+		}
+	}
+
+	sprintf(filename, "%s/board.cells", directory);
+	fp = fopen(filename, "w");
+	sprintf(filename, "%s/board.grid", directory);
+	fg = fopen(filename, "w");
+	if ((fp == NULL) || (fg == NULL)){
+		fprintf(stderr, "Cannot write the boards in %s\n", directory);
+		free(cells);
+		return -1;
+	}
+	for (i = 0; i < N; i++){
+		for (j = 0; j < N; j++){
+			if (cells[i*N + j]) fprintf(fp, "%d %d\n", i, j);
+			fprintf(fg, (j != N-1) ? "%d " : "%d\n", cells[i*N + j]);
+		}
+	}
+	fclose(fp);
+	fclose(fg);
+	free(cells);
+	return 0;
+}
+
+
+
+/*Run a program for some generations and let it write its last one in output (processes 0 for the serial programs)*/
+int run(const char *name, const char *options, int processes, int grid, int N, int generations, const char *rule, const char *output)
+{
+	char command[4*BUFSIZE], mpi[BUFSIZE] = "";
+
+	if (processes > 0) sprintf(mpi, "%s -n %d ", launcher, processes);
+	sprintf(command, "%s../%s -n %d -g %d -i '%s/board.%s' -r '%s' -w '%s' %s > /dev/null 2>&1",
+			mpi, name, N, generations, directory, grid ? "grid" : "cells", rule, output, options);
+	unlink(output);
+	return system(command);
+}
+
+
+
+/*Read the cells a program wrote with -w (returns NULL if the file is missing or it is not an N x N board)*/
+char *readDump(const char *filename, int N)
+{
+	int  i, j, state, side, generations;
+	char *cells;
+	FILE *fp = fopen(filename, "r");
+
+	if (fp == NULL) return NULL;
+	if ((fscanf(fp, "%d %d", &side, &generations) != 2) || (side != N)){
+		fclose(fp);
+		return NULL;
+	}
+	cells = calloc((size_t)N*N, sizeof(char));
+	while (fscanf(fp, "%d %d %d", &i, &j, &state) == 3)
+		if ((i >= 0) && (i < N) && (j >= 0) && (j < N)) cells[i*N + j] = state;
+	fclose(fp);
+	return cells;
+}
+
+
+
+/*Compare two dumps cell by cell, returns 0 if they are the same, 1 with the first different cell (row by row), or -1 if one is missing*/
+int compareDumps(const char *expected, const char *got, int N, int *row, int *col, int *want, int *have)
+{
+	int  k, result = 0;
+	char *a = readDump(expected, N), *b = readDump(got, N);
+
+	if ((a == NULL) || (b == NULL)) result = -1;
+	else {
+		for (k = 0; k < N*N; k++){
+			if (a[k] != b[k]){
+				*row  = k / N;
+				*col  = k % N;
+				*want = a[k];
+				*have = b[k];
+				result = 1;
+				break;
+			}
+		}
+	}
+	free(a);
+	free(b);
+	return result;
+}
+
+
+
+/*Run the reference and the engine for some generations and compare their last ones*/
+int differs(engine *e, int processes, int N, int generations, const char *rule, int *row, int *col, int *want, int *have)
+{
+	char expected[BUFSIZE], got[BUFSIZE];
+
+	sprintf(expected, "%s/bisect.expected", directory);
+	sprintf(got, "%s/bisect.got", directory);
+	run(reference, "", 0, 0, N, generations, rule, expected);
+	run(e->name, e->options, processes, e->grid, N, generations, rule, got);
+	return compareDumps(expected, got, N, row, col, want, have);
+}
+
+
+
+/*Differential verification - In command line (example): ./gol-verify -n 12,48 -g 60 -p 1,4,9,16 -m "mpiexec --oversubscribe"*/
+/*Every engine runs every board and rule it knows and its last generation must be the reference's bit for bit, otherwise the*/
+/*generations are bisected to the first one that differs*/
+int main(int argc, char *argv[])
+{
+	int  i, k, b, r, p, n, sizes[MAX_LIST], ranks[MAX_LIST], nsizes, nranks, generations = 60, keep = 0;
+	int  N, processes, side, result, row = 0, col = 0, want = 0, have = 0, low, high, middle, passed = 0, failed = 0, skipped = 0;
+	unsigned int seed = 1;
+	char expected[BUFSIZE], got[BUFSIZE], command[BUFSIZE];
+	int  nengines = sizeof(engines) / sizeof(engines[0]), nrules = sizeof(rules) / sizeof(rules[0]), nboards = sizeof(boards) / sizeof(boards[0]);
+
+	nsizes = readList("12,48", sizes);
+	nranks = readList("1,4,9,16", ranks);
+
+	/*Read the arguments*/
+	for (i = 0; i < argc; i++){
+		if (!strcmp(argv[i], "-n")) nsizes = readList(argv[++i], sizes);
+		else if (!strcmp(argv[i], "-g")) generations = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-p")) nranks = readList(argv[++i], ranks);
+		else if (!strcmp(argv[i], "-s")) seed = atoi(argv[++i]);
+		else if (!strcmp(argv[i], "-m")) launcher = argv[++i];
+		else if (!strcmp(argv[i], "-k")) keep = 1;
+	}
+	if (generations < 1){
+		fprintf(stderr, "At least one generation is needed\n");
+		return 1;
+	}
+	if (mkdtemp(directory) == NULL){
+		fprintf(stderr, "Cannot create a folder for the boards\n");
+		return 1;
+	}
+	sprintf(expected, "%s/expected", directory);
+	sprintf(got, "%s/got", directory);
+
+	/*One line for every run: PASS, SKIP or FAIL with the first generation and cell that differ*/
+	for (n = 0; n < nsizes; n++){
+		N = sizes[n];
+		for (b = 0; b < nboards; b++){
+			if (writeBoard(boards[b], N, seed) != 0) return 1;
+			for (r = 0; r < nrules; r++){
+				run(reference, "", 0, 0, N, generations, rules[r], expected);
+				for (k = 0; k < nengines; k++){
+					if (!(engines[k].rules & ruleKind(rules[r]))) continue;
+					for (p = 0; p < (engines[k].parallel ? nranks : 1); p++){
+						processes = engines[k].parallel ? ranks[p] : 0;
+						printf("%s processes=%d n=%d rule=%s board=%s generations=%d", engines[k].name, processes, N, rules[r], boards[b], generations-1);
+
+						/*The MPI programs need a square number of processes, with blocks of the same size*/
+						side = (int)sqrt((double)processes);
+						if ((processes > 0) && ((side*side != processes) || (N % side != 0))){
+							printf(" SKIP\n");
+							skipped++;
+							continue;
+						}
+
+						/*The tiled engine needs blocks that it can split into its tiles*/
+						if ((engines[k].tiles > 0) && ((N / ((processes > 0) ? side : 1)) % engines[k].tiles != 0)){
+							printf(" SKIP\n");
+							skipped++;
+							continue;
+						}
+
+						run(engines[k].name, engines[k].options, processes, engines[k].grid, N, generations, rules[r], got);
+						result = compareDumps(expected, got, N, &row, &col, &want, &have);
+						if (result == 0){
+							printf(" PASS\n");
+							passed++;
+							continue;
+						}
+						failed++;
+						if (result < 0){
+							printf(" FAIL no-output\n");
+							continue;
+						}
+
+						/*The cells differ after generations-1 steps, find the first generation that differs*/
+						low  = 1;
+						high = generations;
+						if (differs(&engines[k], processes, N, 1, rules[r], &row, &col, &want, &have) != 0) high = 1;
+						while (high - low > 1){
+							middle = (low + high) / 2;
+							if (differs(&engines[k], processes, N, middle, rules[r], &row, &col, &want, &have) != 0) high = middle;
+							else low = middle;
+						}
+						differs(&engines[k], processes, N, high, rules[r], &row, &col, &want, &have);
+						printf(" FAIL first-generation=%d cell=%d,%d expected=%d got=%d\n", high-1, row, col, want, have);
+					}
+					fflush(stdout);
+				}
+			}
+		}
+	}
+
+	printf("passed=%d failed=%d skipped=%d\n", passed, failed, skipped);
+	if (keep || failed) printf("boards=%s\n", directory);
+	else {
+		sprintf(command, "rm -rf '%s'", directory);
+		system(command);
+	}
+	return (failed > 0);
+}